@@ -6,6 +6,15 @@ cd /d "%~dp0"
 REM Set up Emscripten environment
 call emsdk\emsdk_env.bat
 
+REM "build.bat threads" runs the simulation on Emscripten pthreads (SharedArrayBuffer)
+REM "build.bat profile" compiles in the frame profiler; options can be combined
+set THREAD_FLAGS=
+set PROFILE_FLAGS=
+for %%A in (%*) do (
+    if /I "%%~A"=="threads" set THREAD_FLAGS=-pthread -s PTHREAD_POOL_SIZE=navigator.hardwareConcurrency
+    if /I "%%~A"=="profile" set PROFILE_FLAGS=-DENABLE_PROFILER
+)
+
 REM Create build directory if it doesn't exist
 if not exist build mkdir build
 
@@ -13,12 +22,32 @@ REM Compile C++ to WASM
 emcc src/cpp/main.cpp ^
     src/cpp/engine/renderer.cpp ^
     src/cpp/engine/game.cpp ^
+    src/cpp/engine/entity_store.cpp ^
+    src/cpp/engine/movement.cpp ^
+    src/cpp/engine/job_system.cpp ^
+    src/cpp/engine/spatial_grid.cpp ^
+    src/cpp/engine/culling.cpp ^
+    src/cpp/engine/indicators.cpp ^
+    src/cpp/engine/profiler.cpp ^
+    src/cpp/engine/worker_thread.cpp ^
+    src/cpp/engine/world_file.cpp ^
+    src/cpp/engine/replay.cpp ^
+    src/cpp/engine/timing_wheel.cpp ^
+    src/cpp/engine/collision.cpp ^
+    src/cpp/engine/steering.cpp ^
+    src/cpp/engine/flow_field.cpp ^
+    src/cpp/engine/lod.cpp ^
+    src/cpp/engine/world.cpp ^
+    -msimd128 ^
+    %THREAD_FLAGS% ^
+    %PROFILE_FLAGS% ^
     -s USE_WEBGL2=1 ^
     -s MIN_WEBGL_VERSION=2 ^
     -s MAX_WEBGL_VERSION=2 ^
     -s WASM=1 ^
-    -s EXPORTED_FUNCTIONS=_init,_start_game_loop,_resize_renderer,_malloc,_free ^
-    -s EXPORTED_RUNTIME_METHODS=ccall,cwrap ^
+    -s ALLOW_MEMORY_GROWTH=1 ^
+    -s EXPORTED_FUNCTIONS=_init,_start_game_loop,_resize_renderer,_get_sim_snapshot,_get_profiler_frames,_get_profiler_frame_capacity,_get_profiler_frame_count,_get_world_snapshot_size,_write_world_snapshot,_alloc_world_buffer,_load_world_from_memory,_start_replay_recording,_stop_replay_recording,_get_replay_data,_get_replay_size,_malloc,_free ^
+    -s EXPORTED_RUNTIME_METHODS=ccall,cwrap,HEAPU8,HEAP32,HEAPU32,HEAPF32 ^
     -s MODULARIZE=1 ^
     -s EXPORT_NAME=Module ^
     -O2 ^
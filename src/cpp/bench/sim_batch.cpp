@@ -0,0 +1,226 @@
+// Headless batch runner for parameter sweeps: many independent worlds, one
+// seed each, stepped side by side and summarised one JSON object per line,
+//   {"world":0,"seed":42,"entities":1024,"ticks":600,...,"checksum":"8c1d03a2"}
+// followed by a throughput line,
+//   {"bench":"batch","worlds":256,...,"world_ticks_per_second":5120.0,...}
+//
+// Usage: sim_batch [--worlds N] [--entities N] [--ticks N] [--seed N] [--workers N]
+//                  [--behaviour walk|flock] [--collisions 0|1] [--bounds F]
+//                  [--check N] [--out PATH]
+//
+// With at least as many worlds as workers, each job steps one whole world on
+// one core (World::serial), so the pool interleaves worlds across cores while
+// each world's kernels run SIMD_WIDTH entities at a time. With fewer worlds
+// they are stepped one after another, each spread over the pool.
+//
+// --check re-runs the first N worlds alone the other way round and exits
+// non-zero if any of them ends up different.
+
+#include "world.h"
+#include "job_system.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#define STEP_TIME (1.0f / 60.0f) // seconds per tick
+
+struct BatchOptions {
+    int worlds;
+    int entities;
+    int ticks;
+    uint32_t seed; // of the first world; world k runs seed + k
+    int workers;
+    int behaviour;
+    bool collisions;
+    float bounds;
+    int check;
+    const char* out;
+};
+
+// What a world ran into over the batch
+struct WorldRun {
+    long long contacts; // summed over every tick
+};
+
+struct Batch {
+    const BatchOptions* options;
+    World* worlds;
+    WorldRun* runs;
+};
+
+static double now_seconds() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+static bool setup_world(World& world, const BatchOptions& options, int index, bool serial) {
+    world.seed = options.seed + (uint32_t)index;
+    world.world_bounds = options.bounds;
+    world.ai_behaviour = options.behaviour;
+    world.collisions = options.collisions;
+    world.serial = serial;
+    return world_init(world, options.entities, options.entities);
+}
+
+static void run_world(World& world, const BatchOptions& options, WorldRun& run) {
+    run.contacts = 0;
+    for (int t = 0; t < options.ticks; t++) {
+        world_step(world, STEP_TIME);
+        run.contacts += world.collision_contacts;
+    }
+}
+
+static void run_worlds_job(int begin, int end, void* user_data) {
+    Batch& batch = *(Batch*)user_data;
+    for (int k = begin; k < end; k++) run_world(batch.worlds[k], *batch.options, batch.runs[k]);
+}
+
+// FNV-1a over the entity state in dense order, for comparing runs bit for bit
+static uint32_t world_checksum(const World& world) {
+    const EntityStore& entities = world.entities;
+    const float* arrays[4] = { entities.x, entities.y, entities.vx, entities.vy };
+    uint32_t hash = 2166136261u;
+    for (const float* values : arrays) {
+        for (int i = 0; i < entities.count; i++) {
+            uint32_t bits;
+            memcpy(&bits, &values[i], sizeof(bits));
+            hash = (hash ^ bits) * 16777619u;
+        }
+    }
+    return hash;
+}
+
+static void write_summary(FILE* out, const World& world, int index, const BatchOptions& options,
+                          const WorldRun& run) {
+    const EntityStore& entities = world.entities;
+    int count = entities.count;
+    double sum_x = 0.0, sum_y = 0.0, sum_speed = 0.0;
+    long long decisions = 0;
+    for (int i = 0; i < count; i++) {
+        sum_x += entities.x[i];
+        sum_y += entities.y[i];
+        sum_speed += sqrt((double)entities.vx[i] * entities.vx[i] + (double)entities.vy[i] * entities.vy[i]);
+        decisions += entities.decision_count[i];
+    }
+    double mean_x = count ? sum_x / count : 0.0;
+    double mean_y = count ? sum_y / count : 0.0;
+    double spread = 0.0; // root mean square distance from the centroid
+    for (int i = 0; i < count; i++) {
+        double dx = entities.x[i] - mean_x, dy = entities.y[i] - mean_y;
+        spread += dx * dx + dy * dy;
+    }
+    spread = count ? sqrt(spread / count) : 0.0;
+
+    fprintf(out,
+            "{\"world\":%d,\"seed\":%u,\"entities\":%d,\"ticks\":%u,\"mean_x\":%.3f,\"mean_y\":%.3f,"
+            "\"spread\":%.3f,\"mean_speed\":%.3f,\"decisions\":%lld,\"contacts_per_tick\":%.3f,"
+            "\"checksum\":\"%08x\"}\n",
+            index, world.seed, count, world.tick, mean_x, mean_y, spread, count ? sum_speed / count : 0.0,
+            decisions, options.ticks ? (double)run.contacts / options.ticks : 0.0, world_checksum(world));
+}
+
+int main(int argc, char** argv) {
+    BatchOptions options;
+    options.worlds = 256;
+    options.entities = 1024;
+    options.ticks = 600;
+    options.seed = 42;
+    options.workers = 1;
+    options.behaviour = AI_BEHAVIOUR_RANDOM_WALK;
+    options.collisions = false;
+    options.bounds = 1000.0f;
+    options.check = 4;
+    options.out = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            fprintf(stderr, "missing value for %s\n", arg);
+            return 2;
+        }
+        if (strcmp(arg, "--worlds") == 0) options.worlds = atoi(value);
+        else if (strcmp(arg, "--entities") == 0) options.entities = atoi(value);
+        else if (strcmp(arg, "--ticks") == 0) options.ticks = atoi(value);
+        else if (strcmp(arg, "--seed") == 0) options.seed = (uint32_t)strtoul(value, nullptr, 10);
+        else if (strcmp(arg, "--workers") == 0) options.workers = atoi(value);
+        else if (strcmp(arg, "--behaviour") == 0) {
+            options.behaviour = strcmp(value, "flock") == 0 ? AI_BEHAVIOUR_FLOCK : AI_BEHAVIOUR_RANDOM_WALK;
+        }
+        else if (strcmp(arg, "--collisions") == 0) options.collisions = atoi(value) != 0;
+        else if (strcmp(arg, "--bounds") == 0) options.bounds = (float)atof(value);
+        else if (strcmp(arg, "--check") == 0) options.check = atoi(value);
+        else if (strcmp(arg, "--out") == 0) options.out = value;
+        else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return 2;
+        }
+        i++;
+    }
+    if (options.worlds < 1) options.worlds = 1;
+    if (options.entities < NUM_AI_ENTITIES) options.entities = NUM_AI_ENTITIES;
+    if (options.ticks < 0) options.ticks = 0;
+    if (options.bounds <= 0.0f) options.bounds = 1000.0f;
+    if (options.check > options.worlds) options.check = options.worlds;
+
+    job_system_init(options.workers);
+    int workers = job_system_worker_count();
+    bool per_world = options.worlds >= workers; // one world per job, else one world at a time on the pool
+
+    std::vector<World> worlds(options.worlds);
+    std::vector<WorldRun> runs(options.worlds);
+    for (int k = 0; k < options.worlds; k++) {
+        if (!setup_world(worlds[k], options, k, per_world)) {
+            fprintf(stderr, "could not allocate world %d\n", k);
+            return 1;
+        }
+    }
+
+    Batch batch = { &options, worlds.data(), runs.data() };
+    double start = now_seconds();
+    if (per_world) {
+        job_system_parallel_for(options.worlds, 1, run_worlds_job, &batch);
+    } else {
+        run_worlds_job(0, options.worlds, &batch);
+    }
+    double elapsed = now_seconds() - start;
+
+    FILE* out = options.out ? fopen(options.out, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "could not write %s\n", options.out);
+        return 1;
+    }
+    for (int k = 0; k < options.worlds; k++) write_summary(out, worlds[k], k, options, runs[k]);
+    if (out != stdout) fclose(out);
+
+    // The same worlds stepped alone, with jobs the other way round
+    bool ok = true;
+    for (int k = 0; k < options.check; k++) {
+        World world{};
+        WorldRun run;
+        setup_world(world, options, k, !per_world);
+        run_world(world, options, run);
+        if (world_checksum(world) != world_checksum(worlds[k]) || run.contacts != runs[k].contacts) {
+            fprintf(stderr, "world %d differs when stepped alone\n", k);
+            ok = false;
+        }
+        world_free(world);
+    }
+
+    double world_ticks = (double)options.worlds * options.ticks;
+    printf("{\"bench\":\"batch\",\"worlds\":%d,\"entities\":%d,\"ticks\":%d,\"workers\":%d,\"jobs\":\"%s\","
+           "\"behaviour\":\"%s\",\"collisions\":%s,\"seconds\":%.3f,\"world_ticks_per_second\":%.1f,"
+           "\"ns_per_entity_step\":%.3f,\"checked\":%d,\"identical\":%s}\n",
+           options.worlds, options.entities, options.ticks, workers, per_world ? "worlds" : "entities",
+           options.behaviour == AI_BEHAVIOUR_FLOCK ? "flock" : "walk", options.collisions ? "true" : "false",
+           elapsed, elapsed > 0.0 ? world_ticks / elapsed : 0.0,
+           world_ticks > 0.0 ? elapsed * 1e9 / (world_ticks * options.entities) : 0.0, options.check,
+           ok ? "true" : "false");
+
+    for (World& world : worlds) world_free(world);
+    job_system_shutdown();
+    return ok ? 0 : 1;
+}
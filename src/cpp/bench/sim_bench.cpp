@@ -0,0 +1,1486 @@
+// Headless simulation benchmarks.
+//
+// Prints one JSON object per line so results can be diffed or collected by
+// scripts, e.g.
+//   {"bench":"update","entities":1024,"workers":1,...,"ns_per_entity_step":3.1,...}
+//
+// Usage: sim_bench [--suite all|update|kernel|grid|cull|render|fixed|pipeline|world|replay|collision|steering|flowfield|lod] [--max-entities N] [--workers N]
+//                  [--steps-budget N] [--profile-csv PATH] [--profile-trace PATH] [--enforce-budget]
+//
+// Frame budgets (fits_60hz) are reported, not checked, since they depend on
+// the machine and its load; --enforce-budget makes missing one a failure.
+//
+// The profile dumps need a build configured with -DSIM_ENABLE_PROFILER=ON;
+// each update step of the update suite is recorded as one profiler frame.
+
+#include "game.h"
+#include "entity_store.h"
+#include "world_file.h"
+#include "movement.h"
+#include "job_system.h"
+#include "spatial_grid.h"
+#include "culling.h"
+#include "indicators.h"
+#include "profiler.h"
+#include "renderer.h"
+#include "gl_stub.h"
+#include "worker_thread.h"
+#include "replay.h"
+#include "collision.h"
+#include "steering.h"
+#include "flow_field.h"
+#include "lod.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <vector>
+
+// Allocation counting. Every engine allocation goes through operator new, so
+// replacing the global operators here sees all of them.
+static std::atomic<long long> g_alloc_count(0);
+static std::atomic<long long> g_alloc_bytes(0);
+
+void* operator new(std::size_t size) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add((long long)size, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    g_alloc_bytes.fetch_add((long long)size, std::memory_order_relaxed);
+    size_t alignment = (size_t)align;
+    size_t rounded = (size + alignment - 1) / alignment * alignment;
+    if (void* p = aligned_alloc(alignment, rounded ? rounded : alignment)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    try {
+        return operator new(size, align);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, std::size_t) noexcept { free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { free(p); }
+
+struct BenchOptions {
+    const char* suite;
+    int max_entities;
+    int workers;
+    long long steps_budget; // entity-steps per measurement
+    const char* profile_csv;
+    const char* profile_trace;
+    bool enforce_budget; // fail rows that miss their frame budget
+};
+
+static double now_seconds() {
+    using namespace std::chrono;
+    return duration<double>(steady_clock::now().time_since_epoch()).count();
+}
+
+static int steps_for(const BenchOptions& options, int entities) {
+    long long steps = options.steps_budget / entities;
+    if (steps < 10) steps = 10;
+    if (steps > 100000) steps = 100000;
+    return (int)steps;
+}
+
+// Full update_game cost at each population size
+static void bench_update(const BenchOptions& options) {
+    const float delta_time = 1.0f / 60.0f;
+    set_worker_count(options.workers);
+
+    for (int entities = 4; entities <= options.max_entities; entities *= 4) {
+        int steps = steps_for(options, entities);
+
+        long long allocs_before_init = g_alloc_count.load();
+        init_game(entities, entities);
+        long long allocs_init = g_alloc_count.load() - allocs_before_init;
+
+        // Warm up caches and let every entity take its first decision
+        for (int i = 0; i < 10; i++) update_game(delta_time);
+
+        long long allocs_before = g_alloc_count.load();
+        double start = now_seconds();
+        for (int i = 0; i < steps; i++) {
+            PROFILE_BEGIN_FRAME();
+            update_game(delta_time);
+            PROFILE_END_FRAME();
+        }
+        double elapsed = now_seconds() - start;
+        long long allocs_steps = g_alloc_count.load() - allocs_before;
+
+        printf("{\"bench\":\"update\",\"entities\":%d,\"workers\":%d,\"kernel\":\"%s\",\"steps\":%d,"
+               "\"ns_per_entity_step\":%.3f,\"steps_per_sec\":%.1f,\"allocs_init\":%lld,\"allocs_per_step\":%.3f}\n",
+               entities, job_system_worker_count(), movement_kernel_name(), steps,
+               elapsed * 1e9 / ((double)entities * steps), steps / elapsed, allocs_init,
+               (double)allocs_steps / steps);
+        fflush(stdout);
+
+        if (entities < options.max_entities && entities * 4 > options.max_entities) {
+            entities = options.max_entities / 4;
+        }
+    }
+}
+
+// Vector movement kernel against the scalar reference: throughput of both and
+// a bit-for-bit comparison of the final state
+static bool bench_kernel(const BenchOptions& options) {
+    const int entities = options.max_entities < 65536 ? options.max_entities : 65536;
+    const float bounds = 1000.0f;
+    int steps = steps_for(options, entities);
+
+    std::vector<float> state[2][4];
+    srand(7);
+    for (int k = 0; k < 4; k++) {
+        state[0][k].resize(entities);
+        for (int i = 0; i < entities; i++) {
+            float range = k < 2 ? 1100.0f : 600.0f; // start some entities outside the world
+            state[0][k][i] = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * range;
+        }
+        state[1][k] = state[0][k];
+    }
+
+    double elapsed[2];
+    for (int path = 0; path < 2; path++) {
+        std::vector<float>* s = state[path];
+        double start = now_seconds();
+        for (int step = 0; step < steps; step++) {
+            float delta_time = 1.0f / 60.0f + step * 1e-6f;
+            if (path == 0) {
+                integrate_and_bounce(s[0].data(), s[1].data(), s[2].data(), s[3].data(), entities, delta_time, bounds);
+            } else {
+                integrate_and_bounce_reference(s[0].data(), s[1].data(), s[2].data(), s[3].data(), entities, delta_time, bounds);
+            }
+        }
+        elapsed[path] = now_seconds() - start;
+    }
+
+    bool match = true;
+    for (int k = 0; k < 4; k++) {
+        if (memcmp(state[0][k].data(), state[1][k].data(), entities * sizeof(float)) != 0) match = false;
+    }
+
+    printf("{\"bench\":\"kernel\",\"kernel\":\"%s\",\"entities\":%d,\"steps\":%d,"
+           "\"ns_per_entity_step\":%.3f,\"reference_ns_per_entity_step\":%.3f,\"match\":%s}\n",
+           movement_kernel_name(), entities, steps,
+           elapsed[0] * 1e9 / ((double)entities * steps), elapsed[1] * 1e9 / ((double)entities * steps),
+           match ? "true" : "false");
+    fflush(stdout);
+    return match;
+}
+
+// Spatial grid build and radius queries against a brute-force scan. Both
+// answer the same queries and the result sets are compared.
+static bool bench_grid(const BenchOptions& options) {
+    const float bounds = 1000.0f;
+    const float radius = 50.0f;
+    const int num_queries = 1000;
+    bool all_match = true;
+
+    for (int entities = 1024; entities <= options.max_entities; entities *= 8) {
+        std::vector<float> x(entities), y(entities);
+        srand(11);
+        for (int i = 0; i < entities; i++) {
+            x[i] = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * bounds;
+            y[i] = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * bounds;
+        }
+        std::vector<float> query_x(num_queries), query_y(num_queries);
+        for (int q = 0; q < num_queries; q++) {
+            query_x[q] = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * bounds;
+            query_y[q] = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * bounds;
+        }
+
+        SpatialGrid grid;
+        spatial_grid_init(grid, bounds, radius);
+        double start = now_seconds();
+        spatial_grid_build(grid, x.data(), y.data(), entities);
+        double build_time = now_seconds() - start;
+
+        // Same positions again: the incremental path only compares cells
+        start = now_seconds();
+        spatial_grid_build(grid, x.data(), y.data(), entities);
+        double unchanged_build_time = now_seconds() - start;
+
+        std::vector<int32_t> grid_result(entities), brute_result(entities);
+        long long neighbours = 0;
+        start = now_seconds();
+        for (int q = 0; q < num_queries; q++) {
+            neighbours += spatial_grid_query_radius(grid, x.data(), y.data(), query_x[q], query_y[q], radius,
+                                                    grid_result.data(), entities);
+        }
+        double grid_time = now_seconds() - start;
+
+        // Brute force is O(N) per query, so run fewer of them at large N
+        int brute_queries = (int)std::max(10LL, std::min((long long)num_queries, 20000000LL / entities));
+        bool match = true;
+        double brute_time = 0.0;
+        for (int q = 0; q < brute_queries; q++) {
+            start = now_seconds();
+            int brute_found = 0;
+            for (int i = 0; i < entities; i++) {
+                float dx = x[i] - query_x[q];
+                float dy = y[i] - query_y[q];
+                if (dx * dx + dy * dy <= radius * radius) brute_result[brute_found++] = i;
+            }
+            brute_time += now_seconds() - start;
+
+            int grid_found = spatial_grid_query_radius(grid, x.data(), y.data(), query_x[q], query_y[q], radius,
+                                                       grid_result.data(), entities);
+            std::sort(grid_result.begin(), grid_result.begin() + grid_found);
+            if (grid_found != brute_found ||
+                !std::equal(grid_result.begin(), grid_result.begin() + grid_found, brute_result.begin())) {
+                match = false;
+            }
+        }
+        all_match = all_match && match;
+
+        printf("{\"bench\":\"grid\",\"entities\":%d,\"cell_size\":%.1f,\"build_ms\":%.3f,\"unchanged_build_ms\":%.3f,"
+               "\"avg_neighbours\":%.1f,\"grid_ns_per_query\":%.1f,\"brute_ns_per_query\":%.1f,\"speedup\":%.1f,"
+               "\"match\":%s}\n",
+               entities, radius, build_time * 1e3, unchanged_build_time * 1e3, (double)neighbours / num_queries,
+               grid_time * 1e9 / num_queries, brute_time * 1e9 / brute_queries,
+               (brute_time / brute_queries) / (grid_time / num_queries), match ? "true" : "false");
+        fflush(stdout);
+    }
+    return all_match;
+}
+
+// Per-viewport culling of a 400x400 view at each population size, then the
+// clustering of the off-screen set into edge arrows. The visible and
+// off-screen counts are checked against a linear scan of the snapshot, and the
+// arrows must account for every off-screen entity.
+static bool bench_cull(const BenchOptions& options) {
+    const float half_size = 200.0f;
+    const float delta_time = 1.0f / 60.0f;
+    set_worker_count(options.workers);
+    bool all_match = true;
+
+    for (int entities = 4; entities <= options.max_entities; entities *= 16) {
+        init_game(entities, entities);
+        for (int i = 0; i < 10; i++) update_game(delta_time);
+
+        int center_index = get_ai_index(0);
+        float center_x = get_ai_x(center_index);
+        float center_y = get_ai_y(center_index);
+
+        int culls = (int)std::max(10LL, std::min(10000LL, options.steps_budget / entities));
+        const ViewCull* view = nullptr;
+        double start = now_seconds();
+        for (int c = 0; c < culls; c++) view = cull_ai_view(0, center_x, center_y, half_size, half_size);
+        double elapsed = now_seconds() - start;
+
+        const SimSnapshot* snapshot = get_sim_snapshot();
+        int expected_visible = 0, expected_offscreen = 0;
+        for (int i = 0; i < snapshot->count; i++) {
+            float dx = snapshot->x[i] - center_x;
+            float dy = snapshot->y[i] - center_y;
+            float reach = half_size + CULL_ENTITY_HALF_SIZE;
+            if (dx >= -reach && dx <= reach && dy >= -reach && dy <= reach) expected_visible++;
+            if (dx < -half_size || dx > half_size || dy < -half_size || dy > half_size) expected_offscreen++;
+        }
+
+        IndicatorBuffers indicators;
+        int clusters = 0;
+        start = now_seconds();
+        for (int c = 0; c < culls; c++) {
+            clusters = build_indicator_clusters(indicators, view->offscreen.x, view->offscreen.y, view->offscreen.team,
+                                                view->offscreen.count, center_x, center_y, half_size, half_size,
+                                                40.0f);
+        }
+        double indicator_elapsed = now_seconds() - start;
+        int represented = 0;
+        for (int c = 0; c < clusters; c++) represented += indicators.clusters[c].count;
+
+        bool match = view->visible.count == expected_visible && view->offscreen.count == expected_offscreen &&
+                     represented == view->offscreen.count;
+        all_match = all_match && match;
+
+        printf("{\"bench\":\"cull\",\"entities\":%d,\"visible\":%d,\"offscreen\":%d,\"us_per_cull\":%.2f,"
+               "\"arrows\":%d,\"us_per_arrow_pass\":%.2f,\"match\":%s}\n",
+               entities, view->visible.count, view->offscreen.count, elapsed * 1e6 / culls, clusters,
+               indicator_elapsed * 1e6 / culls, match ? "true" : "false");
+        fflush(stdout);
+    }
+    return all_match;
+}
+
+// Culling plus render_frame_for_viewport for all four viewports on the
+// recording GL stub, so this measures the renderer's CPU side only. One frame
+// is captured and checked: every viewport draws the grid, one instanced call
+// covering exactly its visible entities, and at most one arrow batch.
+static bool bench_render(const BenchOptions& options) {
+    const float delta_time = 1.0f / 60.0f;
+    const int viewport_size = 400;
+    set_worker_count(options.workers);
+    for (int i = 0; i < 4; i++) init_renderer(viewport_size, viewport_size, i);
+    bool all_ok = true;
+
+    for (int entities = 4; entities <= options.max_entities; entities *= 16) {
+        init_game(entities, entities);
+        for (int i = 0; i < 10; i++) update_game(delta_time);
+
+        int frames = (int)std::max(10LL, std::min(1000LL, options.steps_budget / entities));
+        const ViewCull* views[4];
+        auto render_all = [&]() {
+            for (int v = 0; v < 4; v++) {
+                int center_index = get_ai_index(v);
+                float center_x = get_ai_x(center_index);
+                float center_y = get_ai_y(center_index);
+                views[v] = cull_ai_view(v, center_x, center_y, viewport_size / 2.0f, viewport_size / 2.0f);
+                render_frame_for_viewport(center_x, center_y, 50.0f, v, views[v]);
+            }
+        };
+
+        // Captured frame for the draw checks
+        gl_stub_reset();
+        gl_stub_set_recording(true);
+        render_all();
+        gl_stub_set_recording(false);
+
+        int num_commands = 0;
+        const GlStubCommand* commands = gl_stub_commands(&num_commands);
+        int viewport = -1;
+        int draws[4] = {0, 0, 0, 0};
+        long long instances[4] = {0, 0, 0, 0};
+        for (int c = 0; c < num_commands; c++) {
+            if (commands[c].op == GL_STUB_CLEAR) viewport++;
+            if (viewport < 0 || viewport >= 4) continue;
+            if (commands[c].op == GL_STUB_DRAW_ARRAYS) draws[viewport]++;
+            if (commands[c].op == GL_STUB_DRAW_ARRAYS_INSTANCED) {
+                draws[viewport]++;
+                instances[viewport] += commands[c].args[3];
+            }
+        }
+        bool ok = viewport == 3;
+        for (int v = 0; v < 4; v++) {
+            ok = ok && draws[v] <= 3 && instances[v] == views[v]->visible.count;
+        }
+        all_ok = all_ok && ok;
+
+        gl_stub_reset();
+        double start = now_seconds();
+        for (int f = 0; f < frames; f++) render_all();
+        double elapsed = now_seconds() - start;
+        const GlStubStats& stats = gl_stub_stats();
+
+        printf("{\"bench\":\"render\",\"entities\":%d,\"frames\":%d,\"us_per_frame\":%.2f,"
+               "\"draw_calls_per_frame\":%.1f,\"gl_calls_per_frame\":%.1f,\"state_changes_per_frame\":%.1f,"
+               "\"upload_kb_per_frame\":%.2f,\"instances_per_frame\":%.1f,\"ok\":%s}\n",
+               entities, frames, elapsed * 1e6 / frames, (double)stats.draw_calls / frames,
+               (double)stats.calls / frames, (double)stats.state_changes / frames,
+               stats.upload_bytes / 1024.0 / frames, (double)stats.instances_drawn / frames, ok ? "true" : "false");
+        fflush(stdout);
+    }
+    return all_ok;
+}
+
+// Fixed-timestep stepping under different frame pacings (0 = jittered). Each
+// run must end bit-identical to the same number of plain update_game steps,
+// and the interpolation alpha must stay in [0, 1).
+static bool bench_fixed(const BenchOptions& options) {
+    const float tick_rate = 60.0f;
+    const float fixed_step = 1.0f / tick_rate;
+    const float frame_rates[] = {30.0f, 60.0f, 144.0f, 240.0f, 0.0f};
+    const int entities = options.max_entities < 16384 ? options.max_entities : 16384;
+    set_worker_count(options.workers);
+    bool all_match = true;
+
+    for (float frame_rate : frame_rates) {
+        init_game(entities, entities);
+        set_fixed_timestep(tick_rate, 5);
+
+        srand(3);
+        bool alpha_ok = true;
+        int frames = 0;
+        for (float elapsed = 0.0f; elapsed < 10.0f; frames++) {
+            float frame_time = frame_rate > 0.0f ? 1.0f / frame_rate
+                                                 : 0.005f + (float)rand() / (float)RAND_MAX * 0.045f;
+            float alpha = advance_game(frame_time);
+            alpha_ok = alpha_ok && alpha >= 0.0f && alpha < 1.0f;
+            elapsed += frame_time;
+        }
+        uint32_t ticks = get_game_tick();
+
+        const SimSnapshot* snapshot = get_sim_snapshot();
+        std::vector<float> paced_x(snapshot->x, snapshot->x + snapshot->count);
+        std::vector<float> paced_y(snapshot->y, snapshot->y + snapshot->count);
+
+        init_game(entities, entities);
+        set_fixed_timestep(0.0f, 1);
+        for (uint32_t t = 0; t < ticks; t++) update_game(fixed_step);
+        snapshot = get_sim_snapshot();
+
+        bool match = alpha_ok && snapshot->count == (int)paced_x.size() &&
+                     memcmp(snapshot->x, paced_x.data(), paced_x.size() * sizeof(float)) == 0 &&
+                     memcmp(snapshot->y, paced_y.data(), paced_y.size() * sizeof(float)) == 0;
+        all_match = all_match && match;
+
+        printf("{\"bench\":\"fixed\",\"entities\":%d,\"tick_rate\":%.0f,\"frame_rate\":%.0f,\"frames\":%d,"
+               "\"ticks\":%u,\"match\":%s}\n",
+               entities, tick_rate, frame_rate, frames, ticks, match ? "true" : "false");
+        fflush(stdout);
+    }
+    return all_match;
+}
+
+// The render loop with simulation and rendering overlapped: begin_game_step
+// then cull and stub-render all four viewports, synchronously and with async
+// simulation. Reports main-thread time per frame for both, and checks that
+// the async run ends in exactly the state of the synchronous one.
+static bool bench_pipeline(const BenchOptions& options) {
+    const float frame_time = 1.0f / 60.0f;
+    const int viewport_size = 400;
+    set_worker_count(options.workers);
+    set_fixed_timestep(60.0f, 5);
+    for (int i = 0; i < 4; i++) init_renderer(viewport_size, viewport_size, i);
+    bool all_match = true;
+
+    for (int entities = 1024; entities <= options.max_entities; entities *= 8) {
+        int frames = (int)std::max(10LL, std::min(500LL, options.steps_budget / entities));
+        double elapsed[2];
+        std::vector<float> final_x[2], final_y[2];
+
+        for (int async = 0; async < 2; async++) {
+            init_game(entities, entities);
+            set_async_simulation(async);
+
+            double start = now_seconds();
+            for (int f = 0; f < frames; f++) {
+                begin_game_step(frame_time);
+                for (int v = 0; v < 4; v++) {
+                    float center_x = get_camera_x(v);
+                    float center_y = get_camera_y(v);
+                    const ViewCull* view = cull_ai_view(v, center_x, center_y,
+                                                        viewport_size / 2.0f, viewport_size / 2.0f);
+                    render_frame_for_viewport(center_x, center_y, 50.0f, v, view);
+                }
+            }
+            finish_game_step();
+            elapsed[async] = now_seconds() - start;
+
+            // Back to synchronous so the snapshot shows the live world
+            set_async_simulation(0);
+            const SimSnapshot* snapshot = get_sim_snapshot();
+            final_x[async].assign(snapshot->x, snapshot->x + snapshot->count);
+            final_y[async].assign(snapshot->y, snapshot->y + snapshot->count);
+        }
+
+        bool match = final_x[0] == final_x[1] && final_y[0] == final_y[1];
+        all_match = all_match && match;
+
+        printf("{\"bench\":\"pipeline\",\"entities\":%d,\"workers\":%d,\"frames\":%d,\"async\":%s,"
+               "\"sync_us_per_frame\":%.2f,\"async_us_per_frame\":%.2f,\"match\":%s}\n",
+               entities, options.workers, frames, worker_thread_available() ? "true" : "false",
+               elapsed[0] * 1e6 / frames, elapsed[1] * 1e6 / frames, match ? "true" : "false");
+        fflush(stdout);
+    }
+    set_fixed_timestep(0.0f, 1);
+    return all_match;
+}
+
+// World snapshots: time init_game against save_world and the memory-mapped
+// load_world, then check that a loaded world keeps simulating bit-identically
+// to the one that was saved.
+// Loads snapshots with broken id tables, a team out of range and a missing
+// tail; every one must be rejected, and the untouched snapshot accepted
+static bool bench_world_corrupt() {
+    const int entities = 1024;
+    init_game(entities, entities);
+    update_game(1.0f / 60.0f);
+    despawn_ai(entities / 2); // some free ids to corrupt
+    std::vector<uint8_t> pristine(get_world_snapshot_size());
+    write_world_snapshot(pristine.data(), (int)pristine.size());
+
+    const char* cases[] = { "id_out_of_range", "id_to_index_mismatch", "duplicate_free_id", "team_out_of_range",
+                            "truncated" };
+    bool all_rejected = true;
+    for (const char* name : cases) {
+        int size = (int)pristine.size();
+        if (strcmp(name, "truncated") == 0) size -= 64;
+        uint8_t* buffer = (uint8_t*)alloc_world_buffer(size);
+        memcpy(buffer, pristine.data(), size);
+
+        const WorldFileHeader* header = (const WorldFileHeader*)buffer;
+        EntityStore store;
+        entity_store_attach(store, header->capacity, header->count, header->free_id_count,
+                            buffer + header->block_offset);
+        if (strcmp(name, "id_out_of_range") == 0) store.id[3] = (uint32_t)store.capacity + 5;
+        if (strcmp(name, "id_to_index_mismatch") == 0) store.id_to_index[store.id[3]] = 7;
+        if (strcmp(name, "duplicate_free_id") == 0) store.free_ids[0] = store.id[0];
+        if (strcmp(name, "team_out_of_range") == 0) store.team[3] = 7;
+
+        bool rejected = load_world_from_memory(buffer, size) == 0;
+        all_rejected = all_rejected && rejected;
+        printf("{\"bench\":\"world_corrupt\",\"case\":\"%s\",\"rejected\":%s}\n", name,
+               rejected ? "true" : "false");
+    }
+
+    uint8_t* buffer = (uint8_t*)alloc_world_buffer((int)pristine.size());
+    memcpy(buffer, pristine.data(), pristine.size());
+    bool accepted = load_world_from_memory(buffer, (int)pristine.size()) == 1 && get_ai_count() == entities - 1;
+    printf("{\"bench\":\"world_corrupt\",\"case\":\"intact\",\"accepted\":%s}\n", accepted ? "true" : "false");
+
+    // Header values that would size the grid or flow field past any sane
+    // allocation, or carry non-finite state into the step, loaded from a file
+    // so a rejected load can be seen to leave the running world alone
+    std::string path = (std::filesystem::temp_directory_path() / "sim_bench_corrupt.bin").string();
+    const char* header_cases[] = { "bounds_too_large", "cell_size_too_small", "flow_cells_too_many", "ai_speed_nan",
+                                   "accumulator_infinite", "fixed_step_nan" };
+    uint32_t tick = get_game_tick();
+    for (const char* name : header_cases) {
+        std::vector<uint8_t> bytes = pristine;
+        WorldFileHeader* header = (WorldFileHeader*)bytes.data();
+        if (strcmp(name, "bounds_too_large") == 0) header->world_bounds = 2e5f;
+        if (strcmp(name, "cell_size_too_small") == 0) {
+            header->world_bounds = 3e9f;
+            header->spatial_cell_size = 0.001f;
+        }
+        if (strcmp(name, "flow_cells_too_many") == 0) { // fine for the grid, not for 25 px flow cells
+            header->world_bounds = 1e5f;
+            header->spatial_cell_size = 100.0f;
+        }
+        if (strcmp(name, "ai_speed_nan") == 0) header->ai_speed = NAN;
+        if (strcmp(name, "accumulator_infinite") == 0) header->accumulator = INFINITY;
+        if (strcmp(name, "fixed_step_nan") == 0) header->fixed_step = NAN;
+
+        FILE* file = fopen(path.c_str(), "wb");
+        bool written = file && fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size();
+        if (file) fclose(file);
+        bool rejected = written && load_world(path.c_str()) == 0 && get_ai_count() == entities - 1 &&
+                        get_game_tick() == tick;
+        all_rejected = all_rejected && rejected;
+        printf("{\"bench\":\"world_corrupt\",\"case\":\"%s\",\"rejected\":%s}\n", name,
+               rejected ? "true" : "false");
+    }
+    std::filesystem::remove(path);
+
+    // A replay keyframe is a snapshot too, and seeking applies decisions
+    // through its id table
+    start_replay_recording(10);
+    for (int i = 0; i < 5; i++) update_game(1.0f / 60.0f);
+    stop_replay_recording();
+    std::vector<uint8_t> stream(get_replay_data(), get_replay_data() + get_replay_size());
+    Replay replay;
+    ReplayState state = {};
+    uint32_t seek_tick = get_game_tick() - 2;
+    bool replay_rejected = replay_open(replay, stream.data(), stream.size()) && replay_seek(replay, seek_tick, state);
+    if (replay_rejected) { // intact, it seeks fine
+        // Where the id array sits in a block of this capacity
+        const uint8_t* keyframe = stream.data() + replay.keyframes[0].offset + 12; // past the record framing
+        const WorldFileHeader* header = (const WorldFileHeader*)keyframe;
+        EntityStore layout;
+        entity_store_init(layout, header->capacity);
+        size_t id_offset = (size_t)((char*)layout.id - (char*)layout.block);
+        entity_store_free(layout);
+        uint32_t bad_id = (uint32_t)header->capacity + 5;
+        memcpy(stream.data() + replay.keyframes[0].offset + 12 + header->block_offset + id_offset, &bad_id,
+               sizeof(bad_id));
+        replay_rejected = !replay_seek(replay, seek_tick, state);
+    }
+    replay_state_free(state);
+    all_rejected = all_rejected && replay_rejected;
+    printf("{\"bench\":\"world_corrupt\",\"case\":\"replay_keyframe_id_out_of_range\",\"rejected\":%s}\n",
+           replay_rejected ? "true" : "false");
+    fflush(stdout);
+
+    init_game(NUM_AI_ENTITIES, NUM_AI_ENTITIES); // also frees the buffer
+    return all_rejected && accepted;
+}
+
+static bool bench_world(const BenchOptions& options) {
+    const float delta_time = 1.0f / 60.0f;
+    const int steps_after = 20;
+    std::string path = (std::filesystem::temp_directory_path() / "sim_bench_world.bin").string();
+    set_worker_count(options.workers);
+    bool all_match = true;
+
+    for (int entities = 4096; entities <= options.max_entities; entities *= 16) {
+        double start = now_seconds();
+        init_game(entities, entities);
+        double init_elapsed = now_seconds() - start;
+        for (int i = 0; i < 10; i++) update_game(delta_time);
+
+        start = now_seconds();
+        bool saved = save_world(path.c_str()) != 0;
+        double save_elapsed = now_seconds() - start;
+        uint32_t saved_tick = get_game_tick();
+
+        for (int i = 0; i < steps_after; i++) update_game(delta_time);
+        const SimSnapshot* snapshot = get_sim_snapshot();
+        std::vector<float> expected_x(snapshot->x, snapshot->x + snapshot->count);
+        std::vector<float> expected_y(snapshot->y, snapshot->y + snapshot->count);
+
+        start = now_seconds();
+        bool loaded = load_world(path.c_str()) != 0;
+        double load_elapsed = now_seconds() - start;
+        bool match = saved && loaded && get_game_tick() == saved_tick;
+
+        for (int i = 0; i < steps_after; i++) update_game(delta_time);
+        snapshot = get_sim_snapshot();
+        match = match && snapshot->count == (int)expected_x.size() &&
+                memcmp(snapshot->x, expected_x.data(), expected_x.size() * sizeof(float)) == 0 &&
+                memcmp(snapshot->y, expected_y.data(), expected_y.size() * sizeof(float)) == 0;
+        all_match = all_match && match;
+
+        printf("{\"bench\":\"world\",\"entities\":%d,\"file_mb\":%.2f,\"init_ms\":%.3f,\"save_ms\":%.3f,"
+               "\"load_ms\":%.3f,\"match\":%s}\n",
+               entities, get_world_snapshot_size() / (1024.0 * 1024.0), init_elapsed * 1e3, save_elapsed * 1e3,
+               load_elapsed * 1e3, match ? "true" : "false");
+        fflush(stdout);
+    }
+
+    init_game(NUM_AI_ENTITIES, NUM_AI_ENTITIES); // drops the mapping before the file goes
+    std::remove(path.c_str());
+    return bench_world_corrupt() && all_match;
+}
+
+// Records a run with replay keyframes, then seeks the replay to ticks spread
+// over it. Seeks to keyframe ticks must be exact and every other tick within
+// 0.1 px of the recorded run. Reports stream size against full snapshots.
+static bool bench_replay(const BenchOptions& options) {
+    const float delta_time = 1.0f / 60.0f;
+    const int ticks = 1200;
+    const int keyframe_interval = 300;
+    const int check_every = 97; // lands on keyframes now and then, mostly between them
+    const float tolerance = 0.1f; // pixels, a few quantisation steps
+    set_worker_count(options.workers);
+    bool all_ok = true;
+
+    for (int entities = 1024; entities <= options.max_entities && entities <= 262144; entities *= 16) {
+        init_game(entities, entities);
+        start_replay_recording(keyframe_interval);
+
+        std::vector<std::vector<float>> expected_x, expected_y;
+        std::vector<uint32_t> checked_ticks;
+        double start = now_seconds();
+        for (int t = 1; t <= ticks; t++) {
+            update_game(delta_time);
+            if (t % check_every == 0 || t % keyframe_interval == 0) {
+                const SimSnapshot* snapshot = get_sim_snapshot();
+                checked_ticks.push_back((uint32_t)t);
+                expected_x.emplace_back(snapshot->x, snapshot->x + snapshot->count);
+                expected_y.emplace_back(snapshot->y, snapshot->y + snapshot->count);
+            }
+        }
+        double record_elapsed = now_seconds() - start;
+        stop_replay_recording();
+
+        Replay replay;
+        bool ok = replay_open(replay, get_replay_data(), (size_t)get_replay_size()) &&
+                  replay.last_tick == (uint32_t)ticks;
+
+        ReplayState state = {};
+        float max_error = 0.0f;
+        bool keyframes_exact = true;
+        start = now_seconds();
+        for (size_t c = 0; ok && c < checked_ticks.size(); c++) {
+            ok = replay_seek(replay, checked_ticks[c], state) && state.entities.count == entities;
+            for (int i = 0; ok && i < entities; i++) {
+                float error = std::max(fabsf(state.entities.x[i] - expected_x[c][i]),
+                                       fabsf(state.entities.y[i] - expected_y[c][i]));
+                max_error = std::max(max_error, error);
+                // The last tick has no keyframe yet, one is only taken before the next step
+                bool at_keyframe = checked_ticks[c] % keyframe_interval == 0 && checked_ticks[c] < (uint32_t)ticks;
+                if (at_keyframe && error != 0.0f) keyframes_exact = false;
+            }
+        }
+        double seek_elapsed = now_seconds() - start;
+        replay_state_free(state);
+
+        ok = ok && keyframes_exact && max_error <= tolerance;
+        all_ok = all_ok && ok;
+
+        // Keyframe records carry 12 bytes of framing on top of the snapshot
+        size_t keyframe_bytes = replay.keyframes.size() * (world_file_size(entities) + 12);
+        size_t delta_bytes = (size_t)get_replay_size() - keyframe_bytes;
+
+        printf("{\"bench\":\"replay\",\"entities\":%d,\"ticks\":%d,\"keyframes\":%zu,\"stream_kb\":%.1f,"
+               "\"delta_bytes_per_tick\":%.1f,\"full_snapshots_kb\":%.1f,\"record_us_per_tick\":%.2f,"
+               "\"us_per_seek\":%.1f,\"max_error\":%.4f,\"ok\":%s}\n",
+               entities, ticks, replay.keyframes.size(), get_replay_size() / 1024.0, (double)delta_bytes / ticks,
+               (double)world_file_size(entities) * ticks / 1024.0, record_elapsed * 1e6 / ticks,
+               seek_elapsed * 1e6 / checked_ticks.size(), max_error, ok ? "true" : "false");
+        fflush(stdout);
+    }
+    return all_ok;
+}
+
+// Records ticks steps of a fresh world with the current settings, replays the
+// last tick and returns the largest position error, or -1 if the stream could
+// not be replayed. setup, if any, runs between init_game and recording.
+static float replay_drift(int entities, int ticks, float delta_time, void (*setup)() = nullptr) {
+    init_game(entities, entities);
+    if (setup) setup();
+    start_replay_recording(100);
+    for (int t = 0; t < ticks; t++) update_game(delta_time);
+    stop_replay_recording();
+
+    const SimSnapshot* snapshot = get_sim_snapshot();
+    Replay replay;
+    ReplayState state = {};
+    float max_error = -1.0f;
+    if (replay_open(replay, get_replay_data(), (size_t)get_replay_size()) &&
+        replay_seek(replay, (uint32_t)ticks, state) && state.entities.count == entities) {
+        max_error = 0.0f;
+        for (int i = 0; i < entities; i++) {
+            max_error = std::max(max_error, std::max(fabsf(state.entities.x[i] - snapshot->x[i]),
+                                                     fabsf(state.entities.y[i] - snapshot->y[i])));
+        }
+    }
+    replay_state_free(state);
+    return max_error;
+}
+
+// Pairs of entity squares in the current world overlapping by more than half a
+// pixel (pushed-apart pairs end up touching, give or take rounding), found
+// through the public grid query
+static int count_overlaps(std::vector<int>& found) {
+    const SimSnapshot* snapshot = get_sim_snapshot();
+    const float size = COLLISION_SIZE - 0.5f;
+    found.resize(snapshot->count);
+    int overlaps = 0;
+    for (int i = 0; i < snapshot->count; i++) {
+        float x = snapshot->x[i], y = snapshot->y[i];
+        int n = query_ai_aabb(x - size, y - size, x + size, y + size, found.data(), (int)found.size());
+        for (int f = 0; f < n; f++) {
+            int j = found[f];
+            if (j > i && fabsf(snapshot->x[j] - x) < size && fabsf(snapshot->y[j] - y) < size) overlaps++;
+        }
+    }
+    return overlaps;
+}
+
+// Collision stage at constant density: the world grows with the population so
+// every size sees the same crowding. Reports the cost on top of a plain step,
+// checks that the result does not depend on the worker count, that pushes
+// keep overlaps down over time and that replays stay in sync with collisions on.
+static bool bench_collision(const BenchOptions& options) {
+    const float delta_time = 1.0f / 60.0f;
+    const float spacing = 60.0f; // one entity per spacing x spacing pixels
+    const int replay_ticks = 300;
+    int other_workers = options.workers == 1 ? 4 : 1;
+    std::vector<int> found;
+    bool all_ok = true;
+
+    for (int entities = 4096; entities <= options.max_entities; entities *= 4) {
+        int steps = steps_for(options, entities);
+        set_world_bounds(sqrtf((float)entities) * spacing * 0.5f);
+
+        double elapsed[2];
+        int overlaps[2];
+        int contacts = 0;
+        std::vector<float> final_x, final_y;
+        for (int collisions = 0; collisions <= 1; collisions++) {
+            set_worker_count(options.workers);
+            set_collisions(collisions);
+            init_game(entities, entities);
+            update_game(delta_time);
+
+            double start = now_seconds();
+            for (int i = 0; i < steps; i++) update_game(delta_time);
+            elapsed[collisions] = now_seconds() - start;
+            contacts = get_collision_contacts();
+            overlaps[collisions] = count_overlaps(found);
+
+            const SimSnapshot* snapshot = get_sim_snapshot();
+            final_x.assign(snapshot->x, snapshot->x + snapshot->count);
+            final_y.assign(snapshot->y, snapshot->y + snapshot->count);
+        }
+
+        // Same run on a different number of workers must match bit for bit
+        set_worker_count(other_workers);
+        init_game(entities, entities);
+        for (int i = 0; i <= steps; i++) update_game(delta_time);
+        const SimSnapshot* snapshot = get_sim_snapshot();
+        bool deterministic = snapshot->count == entities &&
+                             memcmp(snapshot->x, final_x.data(), entities * sizeof(float)) == 0 &&
+                             memcmp(snapshot->y, final_y.data(), entities * sizeof(float)) == 0;
+
+        // Velocities keep driving entities into each other and one pass per
+        // step leaves some of a crowd for the next, but most overlaps must go
+        bool separated = overlaps[1] * 2 < overlaps[0];
+
+        // Collision pushes are direction changes the replay has to carry;
+        // checked on the smallest world only and reported where it ran
+        char replay_field[40] = "";
+        bool replay_ok = true;
+        if (entities == 4096) {
+            set_worker_count(options.workers);
+            float replay_error = replay_drift(entities, replay_ticks, delta_time);
+            replay_ok = replay_error >= 0.0f && replay_error <= 0.1f;
+            snprintf(replay_field, sizeof(replay_field), ",\"replay_error\":%.4f", replay_error);
+        }
+
+        bool ok = deterministic && separated && replay_ok;
+        all_ok = all_ok && ok;
+
+        printf("{\"bench\":\"collision\",\"entities\":%d,\"workers\":%d,\"world_bounds\":%.0f,\"steps\":%d,"
+               "\"ns_per_entity_step\":%.3f,\"ns_per_entity_step_no_collisions\":%.3f,\"contacts\":%d,"
+               "\"overlaps\":%d,\"overlaps_no_collisions\":%d,\"deterministic\":%s%s,\"ok\":%s}\n",
+               entities, options.workers, sqrtf((float)entities) * spacing * 0.5f, steps,
+               elapsed[1] * 1e9 / ((double)entities * steps), elapsed[0] * 1e9 / ((double)entities * steps),
+               contacts, overlaps[1], overlaps[0], deterministic ? "true" : "false", replay_field, ok ? "true" : "false");
+        fflush(stdout);
+    }
+
+    // Leave the defaults for the other suites
+    set_collisions(0);
+    set_world_bounds(1000.0f);
+    set_worker_count(options.workers);
+    return all_ok;
+}
+
+// Flocking: the vector steering kernel against its scalar reference on one
+// world, then full flocking steps at each population in the default world,
+// where 100k entities are a dense swarm. A step should fit in a 60 Hz frame
+// at 100k on one worker; missing that fails the suite under --enforce-budget
+// only. A mismatch against the reference or between worker counts always fails.
+static bool bench_steering(const BenchOptions& options) {
+    const float delta_time = 1.0f / 60.0f;
+    const float bounds = 1000.0f;
+    bool all_ok = true;
+
+    {
+        int entities = options.max_entities < 65536 ? options.max_entities : 65536;
+        std::vector<float> x(entities), y(entities), vx(entities), vy(entities);
+        std::vector<int32_t> team(entities);
+        srand(11);
+        for (int i = 0; i < entities; i++) {
+            x[i] = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * bounds;
+            y[i] = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * bounds;
+            vx[i] = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * 150.0f;
+            vy[i] = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * 150.0f;
+            team[i] = i % 4;
+        }
+        // A few stacked entities exercise the coincident case
+        for (int i = 1; i < 8 && i < entities; i++) {
+            x[i] = x[0];
+            y[i] = y[0];
+        }
+        SpatialGrid grid;
+        spatial_grid_init(grid, bounds, 50.0f);
+        spatial_grid_build(grid, x.data(), y.data(), entities);
+        SteeringParams params = steering_default_params(150.0f);
+        SteeringCells cells;
+        steering_cells_resize(cells, entities);
+        steering_gather(grid, x.data(), y.data(), vx.data(), vy.data(), team.data(), 0, entities, cells);
+
+        std::vector<float> out[2][2];
+        double elapsed[2];
+        for (int path = 0; path < 2; path++) {
+            out[path][0].resize(entities);
+            out[path][1].resize(entities);
+            double start = now_seconds();
+            if (path == 0) {
+                steering_update(grid, cells, params, delta_time, 0, entities, nullptr, out[path][0].data(),
+                                out[path][1].data());
+            } else {
+                steering_update_reference(grid, cells, params, delta_time, 0, entities, nullptr, out[path][0].data(),
+                                          out[path][1].data());
+            }
+            elapsed[path] = now_seconds() - start;
+        }
+        bool match = memcmp(out[0][0].data(), out[1][0].data(), entities * sizeof(float)) == 0 &&
+                     memcmp(out[0][1].data(), out[1][1].data(), entities * sizeof(float)) == 0;
+        all_ok = all_ok && match;
+
+        printf("{\"bench\":\"steering_kernel\",\"kernel\":\"%s\",\"entities\":%d,\"neighbour_budget\":%d,"
+               "\"ns_per_entity\":%.3f,\"reference_ns_per_entity\":%.3f,\"match\":%s}\n",
+               movement_kernel_name(), entities, STEERING_MAX_NEIGHBOURS, elapsed[0] * 1e9 / entities,
+               elapsed[1] * 1e9 / entities, match ? "true" : "false");
+        fflush(stdout);
+    }
+
+    const int sizes[] = {4096, 16384, 100000, 262144, 1048576};
+    int other_workers = options.workers == 1 ? 4 : 1;
+    set_ai_behaviour(AI_BEHAVIOUR_FLOCK);
+    for (int entities : sizes) {
+        if (entities > options.max_entities) break;
+        int steps = steps_for(options, entities);
+
+        set_worker_count(options.workers);
+        init_game(entities, entities);
+        for (int i = 0; i < 10; i++) update_game(delta_time);
+        double start = now_seconds();
+        for (int i = 0; i < steps; i++) update_game(delta_time);
+        double elapsed = now_seconds() - start;
+
+        const SimSnapshot* snapshot = get_sim_snapshot();
+        std::vector<float> final_x(snapshot->x, snapshot->x + snapshot->count);
+        std::vector<float> final_y(snapshot->y, snapshot->y + snapshot->count);
+
+        set_worker_count(other_workers);
+        init_game(entities, entities);
+        for (int i = 0; i < 10 + steps; i++) update_game(delta_time);
+        snapshot = get_sim_snapshot();
+        bool deterministic = snapshot->count == entities &&
+                             memcmp(snapshot->x, final_x.data(), entities * sizeof(float)) == 0 &&
+                             memcmp(snapshot->y, final_y.data(), entities * sizeof(float)) == 0;
+
+        // Steered velocities change every step and the replay has to keep up;
+        // checked on the smallest world only and reported where it ran
+        char replay_field[40] = "";
+        bool replay_ok = true;
+        if (entities == 4096) {
+            set_worker_count(options.workers);
+            float replay_error = replay_drift(entities, 300, delta_time);
+            replay_ok = replay_error >= 0.0f && replay_error <= 0.1f;
+            snprintf(replay_field, sizeof(replay_field), ",\"replay_error\":%.4f", replay_error);
+        }
+
+        double ms_per_step = elapsed * 1e3 / steps;
+        bool fits_60hz = ms_per_step <= 1000.0 / 60.0;
+        bool budget_checked = options.enforce_budget && options.workers == 1 && entities == 100000;
+        bool ok = deterministic && replay_ok && (fits_60hz || !budget_checked);
+        all_ok = all_ok && ok;
+
+        printf("{\"bench\":\"steering\",\"entities\":%d,\"workers\":%d,\"steps\":%d,\"ns_per_entity_step\":%.3f,"
+               "\"ms_per_step\":%.3f,\"fits_60hz\":%s,\"budget_checked\":%s,\"deterministic\":%s%s,\"ok\":%s}\n",
+               entities, options.workers, steps, elapsed * 1e9 / ((double)entities * steps), ms_per_step,
+               fits_60hz ? "true" : "false", budget_checked ? "true" : "false", deterministic ? "true" : "false",
+               replay_field, ok ? "true" : "false");
+        fflush(stdout);
+    }
+
+    set_ai_behaviour(AI_BEHAVIOUR_RANDOM_WALK);
+    set_worker_count(options.workers);
+    return all_ok;
+}
+
+// Whether a team's fields are a shortest-path solution for the current costs
+// and goals: every cell that reaches a goal steps to an open neighbour whose
+// value is exactly its own minus the step, and nothing else has a direction
+static bool flow_team_consistent(const FlowField& field, int t) {
+    const FlowTeam& team = field.teams[t];
+    const int n = field.cells_per_side;
+    for (int c = 0; c < n * n; c++) {
+        uint32_t value = team.integration[c];
+        int d = team.direction[c];
+        if (value == FLOW_UNREACHABLE || value == 0) {
+            if (d != FLOW_NO_DIRECTION || (value == 0 && !team.goal[c])) return false;
+            continue;
+        }
+        if (d == FLOW_NO_DIRECTION) return false;
+        int cx = c % n, cy = c / n;
+        int tx = cx + flow_direction_dx[d], ty = cy + flow_direction_dy[d];
+        if (tx < 0 || ty < 0 || tx >= n || ty >= n || field.cost[ty * n + tx] == FLOW_BLOCKED) return false;
+        if ((d & 1) && (field.cost[cy * n + tx] == FLOW_BLOCKED || field.cost[ty * n + cx] == FLOW_BLOCKED)) return false;
+        uint32_t step = (uint32_t)field.cost[c] * ((d & 1) ? 14 : 10);
+        if (team.integration[ty * n + tx] + step != value) return false;
+    }
+    return true;
+}
+
+// Blocks or clears a square of cells, clipped to the grid
+static void flow_set_square(FlowField& field, int cx, int cy, int half, uint8_t cost) {
+    const int n = field.cells_per_side;
+    for (int y = std::max(0, cy - half); y <= std::min(n - 1, cy + half); y++) {
+        for (int x = std::max(0, cx - half); x <= std::min(n - 1, cx + half); x++) flow_field_set_cost(field, y * n + x, cost);
+    }
+}
+
+static void set_corner_goals() {
+    add_team_goal(TEAM_RED, 900.0f, 900.0f);
+    add_team_goal(TEAM_BLUE, -900.0f, 900.0f);
+    add_team_goal(TEAM_PURPLE, 900.0f, -900.0f);
+    add_team_goal(TEAM_BROWN, -900.0f, -900.0f);
+    set_flow_cost(-400.0f, -20.0f, 400.0f, 20.0f, 255);
+}
+
+// Mean distance of the current world's entities from their team's corner
+static double mean_goal_distance() {
+    const SimSnapshot* snapshot = get_sim_snapshot();
+    double distance = 0.0;
+    for (int i = 0; i < snapshot->count; i++) {
+        int team = snapshot->team[i];
+        float gx = (team == TEAM_RED || team == TEAM_PURPLE) ? 900.0f : -900.0f;
+        float gy = (team == TEAM_RED || team == TEAM_BLUE) ? 900.0f : -900.0f;
+        distance += sqrtf((snapshot->x[i] - gx) * (snapshot->x[i] - gx) +
+                          (snapshot->y[i] - gy) * (snapshot->y[i] - gy));
+    }
+    return snapshot->count ? distance / snapshot->count : 0.0;
+}
+
+// Flow fields: full builds and incremental updates over growing grids, with
+// every update checked against a rebuild from scratch, then goal seeking in
+// the game, where field work is per cell and agents only pay a lookup
+static bool bench_flowfield(const BenchOptions& options) {
+    const float delta_time = 1.0f / 60.0f;
+    const float cell_size = 25.0f;
+    const int changes = 200;
+    bool all_ok = true;
+
+    for (int side = 80; side <= 640; side *= 2) {
+        FlowField field;
+        flow_field_init(field, side * cell_size * 0.5f, cell_size);
+        const int cells = side * side;
+        srand(23);
+        // Scattered walls, a few cells across
+        for (int i = 0; i < cells / 64; i++) flow_set_square(field, rand() % side, rand() % side, 1, FLOW_BLOCKED);
+        for (int i = 0; i < cells / 64; i++) flow_set_square(field, rand() % side, rand() % side, 2, 1 + rand() % 8);
+        int goal[FLOW_MAX_TEAMS];
+        for (int t = 0; t < FLOW_MAX_TEAMS; t++) {
+            goal[t] = rand() % cells;
+            flow_field_set_goal(field, t, goal[t], true);
+        }
+
+        double start = now_seconds();
+        for (int t = 0; t < FLOW_MAX_TEAMS; t++) flow_field_update_team(field, t);
+        double build_elapsed = now_seconds() - start;
+        bool ok = true;
+        for (int t = 0; t < FLOW_MAX_TEAMS; t++) ok = ok && flow_team_consistent(field, t);
+
+        // Obstacles appear and vanish and goals move; after each change the
+        // fields must equal a rebuild of a copy
+        // [0] goal moves, which redo most of one team's field, [1] obstacle edits
+        double update_elapsed[2] = {0.0, 0.0};
+        long long settled[2] = {0, 0};
+        int made[2] = {0, 0};
+        int checks = 0;
+        FlowField rebuilt;
+        for (int i = 0; i < changes && ok; i++) {
+            int kind = rand() % 4;
+            int t = rand() % FLOW_MAX_TEAMS;
+            if (kind == 0) {
+                flow_field_set_goal(field, t, goal[t], false);
+                goal[t] = rand() % cells;
+                flow_field_set_goal(field, t, goal[t], true);
+            } else {
+                flow_set_square(field, rand() % side, rand() % side, rand() % 3, kind == 1 ? 1 : FLOW_BLOCKED);
+            }
+            start = now_seconds();
+            for (int u = 0; u < FLOW_MAX_TEAMS; u++) flow_field_update_team(field, u);
+            int k = kind == 0 ? 0 : 1;
+            update_elapsed[k] += now_seconds() - start;
+            made[k]++;
+            for (int u = 0; u < FLOW_MAX_TEAMS; u++) settled[k] += field.teams[u].last_update_cells;
+
+            if (side <= 160 || i % 20 == 0) {
+                rebuilt = field;
+                for (int u = 0; u < FLOW_MAX_TEAMS; u++) {
+                    flow_field_rebuild_team(rebuilt, u);
+                    ok = ok && rebuilt.teams[u].integration == field.teams[u].integration &&
+                         flow_team_consistent(field, u);
+                }
+                checks++;
+            }
+        }
+        all_ok = all_ok && ok;
+
+        printf("{\"bench\":\"flowfield_grid\",\"cells_per_side\":%d,\"teams\":%d,\"build_ms_per_team\":%.3f,"
+               "\"build_ns_per_cell\":%.2f,\"goal_moves\":%d,\"goal_move_us\":%.2f,\"goal_move_cells\":%.1f,"
+               "\"obstacle_edits\":%d,\"obstacle_edit_us\":%.2f,\"obstacle_edit_cells\":%.1f,"
+               "\"checked\":%d,\"ok\":%s}\n",
+               side, FLOW_MAX_TEAMS, build_elapsed * 1e3 / FLOW_MAX_TEAMS,
+               build_elapsed * 1e9 / ((double)cells * FLOW_MAX_TEAMS), made[0],
+               update_elapsed[0] * 1e6 / std::max(1, made[0]), (double)settled[0] / std::max(1, made[0]), made[1],
+               update_elapsed[1] * 1e6 / std::max(1, made[1]), (double)settled[1] / std::max(1, made[1]), checks,
+               ok ? "true" : "false");
+        fflush(stdout);
+    }
+
+    int other_workers = options.workers == 1 ? 4 : 1;
+    for (int entities = 4096; entities <= options.max_entities; entities *= 4) {
+        int steps = steps_for(options, entities);
+        double elapsed[2];
+        std::vector<float> final_x, final_y;
+        for (int seeking = 0; seeking <= 1; seeking++) {
+            set_worker_count(options.workers);
+            init_game(entities, entities);
+            if (seeking) set_corner_goals();
+            update_game(delta_time);
+            double start = now_seconds();
+            for (int i = 0; i < steps; i++) update_game(delta_time);
+            elapsed[seeking] = now_seconds() - start;
+        }
+        const SimSnapshot* snapshot = get_sim_snapshot();
+        final_x.assign(snapshot->x, snapshot->x + snapshot->count);
+        final_y.assign(snapshot->y, snapshot->y + snapshot->count);
+
+        // Teams have to actually get closer to their corner: by half the way,
+        // or on runs too short for that, a quarter of what 150 px/s covers
+        set_worker_count(other_workers);
+        init_game(entities, entities);
+        set_corner_goals();
+        double distance[2];
+        distance[0] = mean_goal_distance();
+        for (int i = 0; i <= steps; i++) update_game(delta_time);
+        distance[1] = mean_goal_distance();
+        double travel = 150.0 * delta_time * (steps + 1);
+        bool arrived = distance[0] - distance[1] >= std::min(distance[0] * 0.5, travel * 0.25);
+        snapshot = get_sim_snapshot();
+        bool deterministic = snapshot->count == entities &&
+                             memcmp(snapshot->x, final_x.data(), entities * sizeof(float)) == 0 &&
+                             memcmp(snapshot->y, final_y.data(), entities * sizeof(float)) == 0;
+
+        // The turns are direction changes the replay has to carry; replaying
+        // is checked on the smallest world only and reported where it ran
+        char replay_field[40] = "";
+        bool replay_ok = true;
+        if (entities == 4096) {
+            set_worker_count(options.workers);
+            float replay_error = replay_drift(entities, 300, delta_time, set_corner_goals);
+            replay_ok = replay_error >= 0.0f && replay_error <= 0.1f;
+            snprintf(replay_field, sizeof(replay_field), ",\"replay_error\":%.4f", replay_error);
+        }
+
+        bool ok = deterministic && arrived && replay_ok;
+        all_ok = all_ok && ok;
+        printf("{\"bench\":\"flowfield\",\"entities\":%d,\"workers\":%d,\"steps\":%d,"
+               "\"ns_per_entity_step\":%.3f,\"ns_per_entity_step_random_walk\":%.3f,\"deterministic\":%s,"
+               "\"mean_goal_distance_start\":%.1f,\"mean_goal_distance_end\":%.1f%s,\"ok\":%s}\n",
+               entities, options.workers, steps, elapsed[1] * 1e9 / ((double)entities * steps),
+               elapsed[0] * 1e9 / ((double)entities * steps), deterministic ? "true" : "false", distance[0],
+               distance[1], replay_field, ok ? "true" : "false");
+        fflush(stdout);
+    }
+
+    set_worker_count(options.workers);
+    init_game(NUM_AI_ENTITIES, NUM_AI_ENTITIES); // drops the goals
+    return all_ok;
+}
+
+// Largest and mean per-axis distance between the current world's entities
+// and x/y, matched by index, and how many are further apart than threshold
+static int position_error(const std::vector<float>& x, const std::vector<float>& y, float threshold,
+                          float* max_error, double* mean_error) {
+    const SimSnapshot* snapshot = get_sim_snapshot();
+    int over = 0;
+    *max_error = 0.0f;
+    *mean_error = 0.0;
+    for (int i = 0; i < snapshot->count; i++) {
+        float error = std::max(fabsf(snapshot->x[i] - x[i]), fabsf(snapshot->y[i] - y[i]));
+        *max_error = std::max(*max_error, error);
+        *mean_error += error / snapshot->count;
+        over += error > threshold;
+    }
+    return over;
+}
+
+// Overlaps of the entities within radius of a camera's entity, i.e. on or
+// near screen; *in_view gets how many entities that is. Each counts once
+// however many cameras see it.
+static int count_overlaps_near_cameras(std::vector<int>& found, float radius, int* in_view) {
+    const SimSnapshot* snapshot = get_sim_snapshot();
+    const float size = COLLISION_SIZE - 0.5f;
+    float camera_x[NUM_AI_ENTITIES], camera_y[NUM_AI_ENTITIES];
+    int cameras = 0;
+    for (int id = 0; id < NUM_AI_ENTITIES; id++) {
+        int index = get_ai_index(id);
+        if (index < 0) continue;
+        camera_x[cameras] = snapshot->x[index];
+        camera_y[cameras] = snapshot->y[index];
+        cameras++;
+    }
+    found.resize(snapshot->count);
+    std::vector<int> near;
+    int overlaps = 0;
+    *in_view = 0;
+    for (int c = 0; c < cameras; c++) {
+        int n = query_ai_radius(camera_x[c], camera_y[c], radius, found.data(), (int)found.size());
+        near.assign(found.begin(), found.begin() + n);
+        for (int i : near) {
+            float x = snapshot->x[i], y = snapshot->y[i];
+            bool seen = false;
+            for (int d = 0; d < c && !seen; d++) {
+                float dx = x - camera_x[d], dy = y - camera_y[d];
+                seen = dx * dx + dy * dy <= radius * radius;
+            }
+            if (seen) continue;
+            (*in_view)++;
+            int m = query_ai_aabb(x - size, y - size, x + size, y + size, found.data(), (int)found.size());
+            for (int f = 0; f < m; f++) {
+                int j = found[f];
+                if (j != i && fabsf(snapshot->x[j] - x) < size && fabsf(snapshot->y[j] - y) < size) overlaps++;
+            }
+        }
+    }
+    return overlaps;
+}
+
+// Simulation level of detail. The multi-step kernel against its scalar
+// reference and against stepping one tick at a time, then whole worlds with
+// tiers on against the same worlds stepped in full. A plain random walk never
+// runs tiers, so it must match the full run exactly and leave every entity in
+// tier 0. Flocking and collisions drop far interactions, so positions drift
+// apart and what the cameras show is compared instead: overlaps per entity
+// within half the near radius of a camera, sampled every 60 ticks once 600
+// ticks have let far crowds reach the cameras. Far entities take no pushes, so crowds drift in from them less spread
+// out than they would be; with tiers on the rate may be at most 1.5 times the
+// full rate plus 0.02. That check runs up to 16384 entities; larger rows only
+// report timing and tiers.
+static bool bench_lod(const BenchOptions& options) {
+    const float delta_time = 1.0f / 60.0f;
+    const float speed = 150.0f;
+    bool all_ok = true;
+
+    {
+        const int entities = options.max_entities < 65536 ? options.max_entities : 65536;
+        const float bounds = 1000.0f;
+        std::vector<float> state[3][4];
+        std::vector<float> steps(entities);
+        srand(17);
+        for (int k = 0; k < 4; k++) {
+            state[0][k].resize(entities);
+            for (int i = 0; i < entities; i++) {
+                float range = k < 2 ? bounds : speed;
+                state[0][k][i] = ((float)rand() / (float)RAND_MAX * 2.0f - 1.0f) * range;
+            }
+            state[1][k] = state[2][k] = state[0][k];
+        }
+        for (int i = 0; i < entities; i++) steps[i] = (float)(rand() % 17);
+
+        double elapsed[2];
+        for (int path = 0; path < 2; path++) {
+            std::vector<float>* st = state[path];
+            double start = now_seconds();
+            if (path == 0) {
+                integrate_and_bounce_steps(st[0].data(), st[1].data(), st[2].data(), st[3].data(), steps.data(),
+                                           entities, delta_time, bounds);
+            } else {
+                integrate_and_bounce_steps_reference(st[0].data(), st[1].data(), st[2].data(), st[3].data(),
+                                                     steps.data(), entities, delta_time, bounds);
+            }
+            elapsed[path] = now_seconds() - start;
+        }
+        bool match = true;
+        for (int k = 0; k < 4; k++) {
+            match = match && memcmp(state[0][k].data(), state[1][k].data(), entities * sizeof(float)) == 0;
+        }
+
+        // The same runs one step at a time
+        std::vector<float>* st = state[2];
+        float max_error = 0.0f;
+        int off_by_step = 0;
+        for (int i = 0; i < entities; i++) {
+            for (int n = 0; n < (int)steps[i]; n++) {
+                integrate_and_bounce_reference(&st[0][i], &st[1][i], &st[2][i], &st[3][i], 1, delta_time, bounds);
+            }
+            float error = std::max(fabsf(st[0][i] - state[0][0][i]), fabsf(st[1][i] - state[0][1][i]));
+            max_error = std::max(max_error, error);
+            off_by_step += error > 0.01f;
+        }
+        bool close = max_error <= speed * delta_time && off_by_step * 1000 < entities;
+        // One step is exactly integrate_and_bounce
+        bool one_step = true;
+        {
+            std::vector<float> a[4], b[4];
+            std::vector<float> ones(entities, 1.0f);
+            for (int k = 0; k < 4; k++) a[k] = b[k] = state[1][k];
+            integrate_and_bounce(a[0].data(), a[1].data(), a[2].data(), a[3].data(), entities, delta_time, bounds);
+            integrate_and_bounce_steps(b[0].data(), b[1].data(), b[2].data(), b[3].data(), ones.data(), entities,
+                                       delta_time, bounds);
+            for (int k = 0; k < 4; k++) one_step = one_step && a[k] == b[k];
+        }
+        bool ok = match && close && one_step;
+        all_ok = all_ok && ok;
+
+        printf("{\"bench\":\"lod_kernel\",\"kernel\":\"%s\",\"entities\":%d,\"ns_per_entity\":%.3f,"
+               "\"reference_ns_per_entity\":%.3f,\"match\":%s,\"one_step_exact\":%s,"
+               "\"max_error_vs_stepping\":%.4f,\"off_by_a_step\":%d,\"ok\":%s}\n",
+               movement_kernel_name(), entities, elapsed[0] * 1e9 / entities, elapsed[1] * 1e9 / entities,
+               match ? "true" : "false", one_step ? "true" : "false", max_error, off_by_step, ok ? "true" : "false");
+        fflush(stdout);
+    }
+
+    // A world four times the default area, with the cameras' entities near
+    // its centre, so most of it is far
+    set_world_bounds(2000.0f);
+    const char* behaviours[] = {"random_walk", "collisions", "flock"};
+    const float view_radius = lod_default_params().radius[0] * 0.5f;
+    int other_workers = options.workers == 1 ? 4 : 1;
+    std::vector<int> found;
+    for (int entities = 4096; entities <= options.max_entities; entities *= 4) {
+        int steps = steps_for(options, entities);
+        for (int b = 0; b < 3; b++) {
+            set_collisions(b == 1);
+            set_ai_behaviour(b == 2 ? AI_BEHAVIOUR_FLOCK : AI_BEHAVIOUR_RANDOM_WALK);
+            set_worker_count(options.workers);
+
+            // The same world with tiers off then on. A random walk never runs
+            // tiers, so its final positions must match exactly.
+            double elapsed[2];
+            int tiers[LOD_TIERS] = {0, 0, 0};
+            std::vector<float> full_x, full_y;
+            float max_error = 0.0f;
+            double mean_error = 0.0;
+            int moved = 0;
+            for (int lod = 0; lod <= 1; lod++) {
+                set_simulation_lod(lod);
+                init_game(entities, entities);
+                for (int i = 0; i < 16; i++) update_game(delta_time);
+                double start = now_seconds();
+                for (int i = 0; i < steps; i++) update_game(delta_time);
+                elapsed[lod] = now_seconds() - start;
+                for (int t = 0; t < LOD_TIERS && lod; t++) tiers[t] = get_lod_tier_count(t);
+                if (b != 0) continue;
+                const SimSnapshot* snapshot = get_sim_snapshot();
+                if (lod == 0) {
+                    full_x.assign(snapshot->x, snapshot->x + entities);
+                    full_y.assign(snapshot->y, snapshot->y + entities);
+                } else {
+                    moved = position_error(full_x, full_y, 0.0f, &max_error, &mean_error);
+                }
+            }
+
+            // Overlaps on screen, sampled with every entity brought up to date
+            double rate[2] = {0.0, 0.0};
+            bool measured = b != 0 && entities <= 16384;
+            for (int lod = 0; lod <= 1 && measured; lod++) {
+                set_simulation_lod(lod);
+                init_game(entities, entities);
+                int overlaps = 0, seen = 0;
+                for (int i = 1; i <= 1200; i++) {
+                    update_game(delta_time);
+                    if (i <= 600 || i % 60 != 0) continue;
+                    set_simulation_lod(0);
+                    int in_view;
+                    overlaps += count_overlaps_near_cameras(found, view_radius, &in_view);
+                    seen += in_view;
+                    set_simulation_lod(lod);
+                }
+                rate[lod] = seen ? (double)overlaps / seen : 0.0;
+            }
+            set_simulation_lod(0);
+
+            bool accurate = b == 0 ? moved == 0 && tiers[1] == 0 && tiers[2] == 0
+                                   : tiers[1] > 0 && tiers[2] > 0 && (!measured || rate[1] <= rate[0] * 1.5 + 0.02);
+
+            // Tiers must not depend on the worker count either
+            bool deterministic = true;
+            if (entities == 4096) {
+                std::vector<float> final_x, final_y;
+                for (int w = 0; w < 2; w++) {
+                    set_worker_count(w == 0 ? options.workers : other_workers);
+                    set_simulation_lod(1);
+                    init_game(entities, entities);
+                    for (int i = 0; i < 120; i++) update_game(delta_time);
+                    set_simulation_lod(0);
+                    const SimSnapshot* snapshot = get_sim_snapshot();
+                    if (w == 0) {
+                        final_x.assign(snapshot->x, snapshot->x + entities);
+                        final_y.assign(snapshot->y, snapshot->y + entities);
+                    } else {
+                        deterministic = memcmp(snapshot->x, final_x.data(), entities * sizeof(float)) == 0 &&
+                                        memcmp(snapshot->y, final_y.data(), entities * sizeof(float)) == 0;
+                    }
+                }
+            }
+
+            // Each row reports only what it checks
+            char error_fields[128] = "";
+            if (b == 0) {
+                snprintf(error_fields, sizeof(error_fields),
+                         ",\"max_error\":%.4f,\"mean_error\":%.6f,\"entities_moved\":%d", max_error, mean_error,
+                         moved);
+            } else if (measured) {
+                snprintf(error_fields, sizeof(error_fields), ",\"overlap_rate\":%.4f,\"overlap_rate_full\":%.4f",
+                         rate[1], rate[0]);
+            }
+
+            bool ok = accurate && deterministic;
+            all_ok = all_ok && ok;
+            printf("{\"bench\":\"lod\",\"behaviour\":\"%s\",\"entities\":%d,\"workers\":%d,\"steps\":%d,"
+                   "\"ns_per_entity_step\":%.3f,\"ns_per_entity_step_full\":%.3f,\"speedup\":%.2f,"
+                   "\"tier_counts\":[%d,%d,%d]%s,\"deterministic\":%s,\"ok\":%s}\n",
+                   behaviours[b], entities, options.workers, steps, elapsed[1] * 1e9 / ((double)entities * steps),
+                   elapsed[0] * 1e9 / ((double)entities * steps), elapsed[0] / elapsed[1], tiers[0], tiers[1],
+                   tiers[2], error_fields, deterministic ? "true" : "false", ok ? "true" : "false");
+            fflush(stdout);
+        }
+    }
+
+    // Leave the defaults for the other suites
+    set_simulation_lod(0);
+    set_collisions(0);
+    set_ai_behaviour(AI_BEHAVIOUR_RANDOM_WALK);
+    set_world_bounds(1000.0f);
+    set_worker_count(options.workers);
+    return all_ok;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    options.suite = "all";
+    options.max_entities = 1 << 20;
+    options.workers = 1;
+    options.steps_budget = 20000000;
+    options.profile_csv = nullptr;
+    options.profile_trace = nullptr;
+    options.enforce_budget = false;
+
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        if (strcmp(arg, "--enforce-budget") == 0) {
+            options.enforce_budget = true;
+            continue;
+        }
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            fprintf(stderr, "missing value for %s\n", arg);
+            return 2;
+        }
+        if (strcmp(arg, "--suite") == 0) options.suite = value;
+        else if (strcmp(arg, "--max-entities") == 0) options.max_entities = atoi(value);
+        else if (strcmp(arg, "--workers") == 0) options.workers = atoi(value);
+        else if (strcmp(arg, "--steps-budget") == 0) options.steps_budget = atoll(value);
+        else if (strcmp(arg, "--profile-csv") == 0) options.profile_csv = value;
+        else if (strcmp(arg, "--profile-trace") == 0) options.profile_trace = value;
+        else {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return 2;
+        }
+        i++;
+    }
+    if (options.max_entities < 4) options.max_entities = 4;
+    if (options.steps_budget < 1) options.steps_budget = 1;
+
+    bool all = strcmp(options.suite, "all") == 0;
+    bool ok = true;
+
+    if (all || strcmp(options.suite, "kernel") == 0) ok = bench_kernel(options) && ok;
+    if (all || strcmp(options.suite, "update") == 0) bench_update(options);
+    if (all || strcmp(options.suite, "grid") == 0) ok = bench_grid(options) && ok;
+    if (all || strcmp(options.suite, "cull") == 0) ok = bench_cull(options) && ok;
+    if (all || strcmp(options.suite, "render") == 0) ok = bench_render(options) && ok;
+    if (all || strcmp(options.suite, "fixed") == 0) ok = bench_fixed(options) && ok;
+    if (all || strcmp(options.suite, "pipeline") == 0) ok = bench_pipeline(options) && ok;
+    if (all || strcmp(options.suite, "world") == 0) ok = bench_world(options) && ok;
+    if (all || strcmp(options.suite, "replay") == 0) ok = bench_replay(options) && ok;
+    if (all || strcmp(options.suite, "collision") == 0) ok = bench_collision(options) && ok;
+    if (all || strcmp(options.suite, "steering") == 0) ok = bench_steering(options) && ok;
+    if (all || strcmp(options.suite, "flowfield") == 0) ok = bench_flowfield(options) && ok;
+    if (all || strcmp(options.suite, "lod") == 0) ok = bench_lod(options) && ok;
+
+#ifndef ENABLE_PROFILER
+    if (options.profile_csv || options.profile_trace) {
+        fprintf(stderr, "profiler not compiled in, configure with -DSIM_ENABLE_PROFILER=ON\n");
+    }
+#endif
+    if (options.profile_csv && !profiler_write_csv(options.profile_csv)) {
+        fprintf(stderr, "could not write %s\n", options.profile_csv);
+        ok = false;
+    }
+    if (options.profile_trace && !profiler_write_chrome_trace(options.profile_trace)) {
+        fprintf(stderr, "could not write %s\n", options.profile_trace);
+        ok = false;
+    }
+
+    worker_thread_shutdown();
+    job_system_shutdown();
+    return ok ? 0 : 1;
+}
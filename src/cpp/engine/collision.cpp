@@ -0,0 +1,68 @@
+#include "collision.h"
+
+void collision_gather(const SpatialGrid& grid, const float* x, const float* y, int begin, int end,
+                      float* cell_x, float* cell_y) {
+    const int32_t* cell_entities = grid.cell_entities.data();
+    for (int k = begin; k < end; k++) {
+        int i = cell_entities[k];
+        cell_x[k] = x[i];
+        cell_y[k] = y[i];
+    }
+}
+
+static inline float clamp_push(float push) {
+    return push < -COLLISION_MAX_PUSH ? -COLLISION_MAX_PUSH : (push > COLLISION_MAX_PUSH ? COLLISION_MAX_PUSH : push);
+}
+
+int collision_compute_pushes(const SpatialGrid& grid, const float* cell_x, const float* cell_y, int begin, int end,
+                             const uint8_t* skip, float* push_x, float* push_y) {
+    const int32_t* cell_start = grid.cell_start.data();
+    const int32_t* cell_entities = grid.cell_entities.data();
+    const float size = COLLISION_SIZE;
+    int contacts = 0;
+
+    for (int a = begin; a < end; a++) {
+        int i = cell_entities[a];
+        if (skip && skip[i]) {
+            push_x[i] = 0.0f;
+            push_y[i] = 0.0f;
+            continue;
+        }
+        float xi = cell_x[a], yi = cell_y[a];
+        float px = 0.0f, py = 0.0f;
+
+        // Every square overlapping this one has its centre within size on both
+        // axes. A row's cells are adjacent in the grid, so each row's span of
+        // candidates is one range.
+        int cell_min_x = spatial_grid_axis_cell(grid, xi - size), cell_max_x = spatial_grid_axis_cell(grid, xi + size);
+        int cell_min_y = spatial_grid_axis_cell(grid, yi - size), cell_max_y = spatial_grid_axis_cell(grid, yi + size);
+
+        for (int cy = cell_min_y; cy <= cell_max_y; cy++) {
+            int row = cy * grid.cells_per_side;
+            int k_end = cell_start[row + cell_max_x + 1];
+            for (int k = cell_start[row + cell_min_x]; k < k_end; k++) {
+                float dx = xi - cell_x[k], dy = yi - cell_y[k];
+                int j = cell_entities[k];
+
+                // Straight-line arithmetic rather than branches, since whether
+                // a candidate overlaps is as good as random. Overlaps are
+                // clamped at zero, so a pair apart on either axis pushes by 0.
+                float overlap_x = fmaxf(size - fabsf(dx), 0.0f), overlap_y = fmaxf(size - fabsf(dy), 0.0f);
+                float along_x = (float)(overlap_x <= overlap_y);
+
+                // Coincident centres split by index; the entity itself gets 0
+                float away = (float)((i > j) - (i < j));
+                float sign_x = (float)((dx > 0.0f) - (dx < 0.0f)) + away * (float)(dx == 0.0f);
+                float sign_y = (float)((dy > 0.0f) - (dy < 0.0f)) + away * (float)(dy == 0.0f);
+                px += along_x * sign_x * overlap_x * 0.5f;
+                py += (1.0f - along_x) * sign_y * overlap_y * 0.5f;
+                contacts += (overlap_x > 0.0f) & (overlap_y > 0.0f) & (j != i);
+            }
+        }
+
+        // Crowds resolve over several steps rather than scattering in one
+        push_x[i] = clamp_push(px);
+        push_y[i] = clamp_push(py);
+    }
+    return contacts;
+}
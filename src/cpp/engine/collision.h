@@ -0,0 +1,37 @@
+#ifndef COLLISION_H
+#define COLLISION_H
+
+#include "spatial_grid.h"
+
+// Entity squares are COLLISION_SIZE on a side, as drawn by the renderer
+#define COLLISION_SIZE 20.0f
+// Largest push on either axis in one pass, so interpolation and culling can
+// still bound how far an entity moves per step
+#define COLLISION_MAX_PUSH (COLLISION_SIZE * 0.5f)
+
+// Agent-agent collision, one Jacobi pass at a time. The broadphase is the
+// spatial grid: each entity only looks at the grid cells its square can reach.
+// The narrowphase separates every overlapping pair of squares along their
+// axis of least penetration, each square taking half. Pushes are computed
+// from positions that nothing writes during the pass and each entity only
+// writes its own push, so ranges can run in parallel in any order and the
+// result does not depend on the split.
+//
+// Both phases walk entities in grid order, so neighbouring entities, their
+// cells and their candidates are close together in memory.
+
+// Copies positions into grid order, cell_x[k] = x[grid.cell_entities[k]] for
+// k in [begin, end)
+void collision_gather(const SpatialGrid& grid, const float* x, const float* y, int begin, int end,
+                      float* cell_x, float* cell_y);
+
+// For the entities at grid positions [begin, end), writes each one's push,
+// clamped to COLLISION_MAX_PUSH, to push_x/push_y at its store index and
+// returns how many overlaps they had (each pair counts twice). cell_x/cell_y
+// must have been gathered from the current grid. Entities with skip[i] set
+// (by store index; skip may be null) get no push and count no overlaps, but
+// still push the others.
+int collision_compute_pushes(const SpatialGrid& grid, const float* cell_x, const float* cell_y, int begin, int end,
+                             const uint8_t* skip, float* push_x, float* push_y);
+
+#endif
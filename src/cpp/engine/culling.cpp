@@ -0,0 +1,114 @@
+#include "culling.h"
+#include <cmath>
+
+// How a whole cell relates to a rectangle
+enum CellCover {
+    COVER_NONE,   // no entity of the cell can be inside
+    COVER_ALL,    // every entity of the cell is inside
+    COVER_PARTIAL // entities have to be tested
+};
+
+// Cell bounds are widened by a slack so an entity rounded into a neighbouring
+// cell by the grid's float maths, or drawn short of its cell by interpolation,
+// is never misclassified
+static CellCover cover_of(float cell_x0, float cell_y0, float cell_x1, float cell_y1, float slack,
+                          float min_x, float min_y, float max_x, float max_y) {
+    if (cell_x1 + slack < min_x || cell_x0 - slack > max_x || cell_y1 + slack < min_y || cell_y0 - slack > max_y) {
+        return COVER_NONE;
+    }
+    if (cell_x0 - slack >= min_x && cell_x1 + slack <= max_x && cell_y0 - slack >= min_y && cell_y1 + slack <= max_y) {
+        return COVER_ALL;
+    }
+    return COVER_PARTIAL;
+}
+
+void cull_view(CullBuffers& buffers, ViewCull& out, const SpatialGrid& grid,
+               const float* x, const float* y, const int32_t* team,
+               const float* prev_x, const float* prev_y, float alpha, float max_travel,
+               float min_x, float min_y, float max_x, float max_y) {
+    // Squares overlap the view while their centre is inside the padded rectangle
+    float pad_min_x = min_x - CULL_ENTITY_HALF_SIZE, pad_max_x = max_x + CULL_ENTITY_HALF_SIZE;
+    float pad_min_y = min_y - CULL_ENTITY_HALF_SIZE, pad_max_y = max_y + CULL_ENTITY_HALF_SIZE;
+
+    // Size for the worst case once so the scatter below never reallocates
+    size_t capacity = (size_t)grid.entity_count;
+    if (buffers.visible_x.size() < capacity) {
+        buffers.visible_x.resize(capacity);
+        buffers.visible_y.resize(capacity);
+        buffers.visible_team.resize(capacity);
+        buffers.offscreen_x.resize(capacity);
+        buffers.offscreen_y.resize(capacity);
+        buffers.offscreen_team.resize(capacity);
+    }
+    float* visible_x = buffers.visible_x.data();
+    float* visible_y = buffers.visible_y.data();
+    int32_t* visible_team = buffers.visible_team.data();
+    float* offscreen_x = buffers.offscreen_x.data();
+    float* offscreen_y = buffers.offscreen_y.data();
+    int32_t* offscreen_team = buffers.offscreen_team.data();
+    int num_visible = 0, num_offscreen = 0;
+
+    if (grid.valid) {
+        const int32_t* cell_start = grid.cell_start.data();
+        const int32_t* cell_entities = grid.cell_entities.data();
+        int last = grid.cells_per_side - 1;
+        float slack = grid.cell_size * 1e-3f + max_travel;
+
+        for (int cy = 0; cy <= last; cy++) {
+            // Edge cells also hold everything clamped in from outside the world
+            float cell_y0 = cy == 0 ? -INFINITY : grid.origin + cy * grid.cell_size;
+            float cell_y1 = cy == last ? INFINITY : grid.origin + (cy + 1) * grid.cell_size;
+
+            for (int cx = 0; cx <= last; cx++) {
+                int cell = cy * grid.cells_per_side + cx;
+                int begin = cell_start[cell], end = cell_start[cell + 1];
+                if (begin == end) continue;
+
+                float cell_x0 = cx == 0 ? -INFINITY : grid.origin + cx * grid.cell_size;
+                float cell_x1 = cx == last ? INFINITY : grid.origin + (cx + 1) * grid.cell_size;
+
+                CellCover visible = cover_of(cell_x0, cell_y0, cell_x1, cell_y1, slack,
+                                             pad_min_x, pad_min_y, pad_max_x, pad_max_y);
+                CellCover on_screen = cover_of(cell_x0, cell_y0, cell_x1, cell_y1, slack,
+                                               min_x, min_y, max_x, max_y);
+
+                for (int k = begin; k < end; k++) {
+                    int i = cell_entities[k];
+                    float ex = x[i], ey = y[i];
+                    if (prev_x) {
+                        ex = prev_x[i] + (ex - prev_x[i]) * alpha;
+                        ey = prev_y[i] + (ey - prev_y[i]) * alpha;
+                    }
+
+                    bool is_visible = visible == COVER_ALL ||
+                        (visible == COVER_PARTIAL &&
+                         ex >= pad_min_x && ex <= pad_max_x && ey >= pad_min_y && ey <= pad_max_y);
+                    bool is_offscreen = on_screen == COVER_NONE ||
+                        (on_screen == COVER_PARTIAL && (ex < min_x || ex > max_x || ey < min_y || ey > max_y));
+
+                    if (is_visible) {
+                        visible_x[num_visible] = ex;
+                        visible_y[num_visible] = ey;
+                        visible_team[num_visible] = team[i];
+                        num_visible++;
+                    }
+                    if (is_offscreen) {
+                        offscreen_x[num_offscreen] = ex;
+                        offscreen_y[num_offscreen] = ey;
+                        offscreen_team[num_offscreen] = team[i];
+                        num_offscreen++;
+                    }
+                }
+            }
+        }
+    }
+
+    out.visible.x = visible_x;
+    out.visible.y = visible_y;
+    out.visible.team = visible_team;
+    out.visible.count = num_visible;
+    out.offscreen.x = offscreen_x;
+    out.offscreen.y = offscreen_y;
+    out.offscreen.team = offscreen_team;
+    out.offscreen.count = num_offscreen;
+}
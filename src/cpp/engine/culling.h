@@ -0,0 +1,49 @@
+#ifndef CULLING_H
+#define CULLING_H
+
+#include "spatial_grid.h"
+#include <cstdint>
+#include <vector>
+
+// Entity squares are 20x20, so a square is partly on screen while its centre
+// is within this distance of the view rectangle
+#define CULL_ENTITY_HALF_SIZE 10.0f
+
+// Entities of one cull set gathered into parallel arrays of count elements
+struct CullSet {
+    const float* x;
+    const float* y;
+    const int32_t* team;
+    int32_t count;
+};
+
+// Result of culling the world against one view rectangle. visible holds every
+// entity whose square overlaps the view (ready for instancing); offscreen holds
+// every entity whose centre lies outside it (the ones that get edge arrows).
+// Squares straddling the border are in both, as before culling.
+struct ViewCull {
+    CullSet visible;
+    CullSet offscreen;
+};
+
+// Backing storage for one ViewCull, reused from frame to frame
+struct CullBuffers {
+    std::vector<float> visible_x, visible_y;
+    std::vector<int32_t> visible_team;
+    std::vector<float> offscreen_x, offscreen_y;
+    std::vector<int32_t> offscreen_team;
+};
+
+// Classify every entity against [min_x, max_x] x [min_y, max_y] by walking the
+// grid cells: cells inside the view or clear of it are copied whole, and only
+// cells crossing the border test their entities one by one. The grid must be
+// built from the same x/y arrays. out points into buffers until the next call.
+// With prev_x/prev_y, entities are classified and gathered at
+// prev + (x - prev) * alpha instead; max_travel bounds |x - prev| so whole
+// cells can still be accepted or rejected.
+void cull_view(CullBuffers& buffers, ViewCull& out, const SpatialGrid& grid,
+               const float* x, const float* y, const int32_t* team,
+               const float* prev_x, const float* prev_y, float alpha, float max_travel,
+               float min_x, float min_y, float max_x, float max_y);
+
+#endif
@@ -0,0 +1,159 @@
+#include "entity_store.h"
+#include <cstring> // for memset
+#include <new> // for aligned operator new
+#include <vector>
+
+#define ENTITY_STORE_NUM_ARRAYS 12
+
+static int pad_capacity(int capacity) {
+    return (capacity + ENTITY_STORE_LANE_PADDING - 1) / ENTITY_STORE_LANE_PADDING * ENTITY_STORE_LANE_PADDING;
+}
+
+// Every array holds one 4-byte element per entity and the padded capacity
+// is a multiple of 16, so each array starts on a 64-byte boundary.
+static void lay_out_arrays(EntityStore& store, int capacity, void* block) {
+    size_t array_bytes = (size_t)pad_capacity(capacity) * 4;
+    char* cursor = (char*)block;
+    store.x = (float*)cursor; cursor += array_bytes;
+    store.y = (float*)cursor; cursor += array_bytes;
+    store.vx = (float*)cursor; cursor += array_bytes;
+    store.vy = (float*)cursor; cursor += array_bytes;
+    store.prev_x = (float*)cursor; cursor += array_bytes;
+    store.prev_y = (float*)cursor; cursor += array_bytes;
+    store.decision_tick = (uint32_t*)cursor; cursor += array_bytes;
+    store.decision_count = (uint32_t*)cursor; cursor += array_bytes;
+    store.team = (int32_t*)cursor; cursor += array_bytes;
+    store.id = (uint32_t*)cursor; cursor += array_bytes;
+    store.id_to_index = (int32_t*)cursor; cursor += array_bytes;
+    store.free_ids = (uint32_t*)cursor;
+
+    store.block = block;
+    store.capacity = capacity;
+}
+
+size_t entity_store_block_size(int capacity) {
+    return (size_t)pad_capacity(capacity) * 4 * ENTITY_STORE_NUM_ARRAYS;
+}
+
+bool entity_store_init(EntityStore& store, int capacity) {
+    memset(&store, 0, sizeof(store));
+    if (capacity <= 0) return false;
+
+    size_t block_size = entity_store_block_size(capacity);
+    void* block = ::operator new(block_size, std::align_val_t(ENTITY_STORE_ALIGNMENT), std::nothrow);
+    if (!block) return false;
+    memset(block, 0, block_size);
+
+    lay_out_arrays(store, capacity, block);
+    store.owns_block = true;
+    entity_store_clear(store);
+    return true;
+}
+
+bool entity_store_ids_consistent(const EntityStore& store) {
+    const int capacity = store.capacity;
+    std::vector<uint8_t> used(capacity, 0);
+    for (int i = 0; i < store.count; i++) {
+        uint32_t id = store.id[i];
+        if (id >= (uint32_t)capacity || used[id] || store.id_to_index[id] != i) return false;
+        used[id] = 1;
+    }
+    for (int f = 0; f < store.free_id_count; f++) {
+        uint32_t id = store.free_ids[f];
+        if (id >= (uint32_t)capacity || used[id] || store.id_to_index[id] != -1) return false;
+        used[id] = 1;
+    }
+    return true;
+}
+
+bool entity_store_attach(EntityStore& store, int capacity, int count, int free_id_count, void* block) {
+    memset(&store, 0, sizeof(store));
+    if (capacity <= 0 || count < 0 || count > capacity || free_id_count != capacity - count) return false;
+    if ((uintptr_t)block % ENTITY_STORE_ALIGNMENT != 0) return false;
+
+    lay_out_arrays(store, capacity, block);
+    store.count = count;
+    store.free_id_count = free_id_count;
+    if (!entity_store_ids_consistent(store)) {
+        memset(&store, 0, sizeof(store));
+        return false;
+    }
+    return true;
+}
+
+void entity_store_free(EntityStore& store) {
+    if (store.block && store.owns_block) {
+        ::operator delete(store.block, std::align_val_t(ENTITY_STORE_ALIGNMENT));
+    }
+    memset(&store, 0, sizeof(store));
+}
+
+void entity_store_clear(EntityStore& store) {
+    store.count = 0;
+
+    // Push ids in reverse so the first spawns get ids 0, 1, 2...
+    store.free_id_count = store.capacity;
+    for (int i = 0; i < store.capacity; i++) {
+        store.free_ids[i] = (uint32_t)(store.capacity - 1 - i);
+        store.id_to_index[i] = -1;
+    }
+}
+
+int entity_store_spawn(EntityStore& store, float x, float y, int team) {
+    if (store.count >= store.capacity || store.free_id_count == 0) return -1;
+
+    int index = store.count++;
+    uint32_t id = store.free_ids[--store.free_id_count];
+
+    store.x[index] = x;
+    store.y[index] = y;
+    store.vx[index] = 0.0f;
+    store.vy[index] = 0.0f;
+    store.prev_x[index] = x;
+    store.prev_y[index] = y;
+    store.decision_tick[index] = 0;
+    store.decision_count[index] = 0;
+    store.team[index] = team;
+    store.id[index] = id;
+    store.id_to_index[id] = index;
+    return index;
+}
+
+bool entity_store_despawn(EntityStore& store, int index) {
+    if (index < 0 || index >= store.count) return false;
+
+    uint32_t id = store.id[index];
+    int last = --store.count;
+
+    // Move the last entity into the hole to keep the arrays dense
+    if (index != last) {
+        store.x[index] = store.x[last];
+        store.y[index] = store.y[last];
+        store.vx[index] = store.vx[last];
+        store.vy[index] = store.vy[last];
+        store.prev_x[index] = store.prev_x[last];
+        store.prev_y[index] = store.prev_y[last];
+        store.decision_tick[index] = store.decision_tick[last];
+        store.decision_count[index] = store.decision_count[last];
+        store.team[index] = store.team[last];
+        store.id[index] = store.id[last];
+        store.id_to_index[store.id[index]] = index;
+    }
+
+    // Zero the vacated slot so padded vector lanes never see stale data
+    store.x[last] = 0.0f;
+    store.y[last] = 0.0f;
+    store.vx[last] = 0.0f;
+    store.vy[last] = 0.0f;
+    store.prev_x[last] = 0.0f;
+    store.prev_y[last] = 0.0f;
+
+    store.id_to_index[id] = -1;
+    store.free_ids[store.free_id_count++] = id;
+    return true;
+}
+
+int entity_store_index_of(const EntityStore& store, uint32_t id) {
+    if (id >= (uint32_t)store.capacity) return -1;
+    return store.id_to_index[id];
+}
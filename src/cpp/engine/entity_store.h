@@ -0,0 +1,63 @@
+#ifndef ENTITY_STORE_H
+#define ENTITY_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Arrays are padded to a multiple of this many entities so vector kernels can
+// always run whole lanes without a scalar tail.
+#define ENTITY_STORE_LANE_PADDING 16
+#define ENTITY_STORE_ALIGNMENT 64 // cache line, the alignment of every array
+
+// Structure-of-arrays storage for AI entities.
+// Live entities are kept densely packed in [0, count); despawning swaps the
+// last entity into the freed slot. Stable ids survive that reordering and are
+// mapped back to the current dense index through id_to_index.
+struct EntityStore {
+    float* x;
+    float* y;
+    float* vx;
+    float* vy;
+    float* prev_x;         // position before the last update, for render interpolation
+    float* prev_y;
+    uint32_t* decision_tick;  // tick of the next direction change
+    uint32_t* decision_count; // direction re-rolls so far, the RNG counter
+    int32_t* team;
+    uint32_t* id;          // dense index -> stable id
+    int32_t* id_to_index;  // stable id -> dense index (-1 when free)
+    uint32_t* free_ids;    // stack of unused ids
+    int free_id_count;
+    int count;
+    int capacity;
+    void* block;           // single allocation backing every array above
+    bool owns_block;       // false when attached to memory owned elsewhere (a mapped world file)
+};
+
+bool entity_store_init(EntityStore& store, int capacity);
+void entity_store_free(EntityStore& store);
+
+// Bytes of the block backing a store of this capacity. The layout depends on
+// the capacity alone, so a block can be saved and attached again as is.
+size_t entity_store_block_size(int capacity);
+// Lays the arrays over an existing ENTITY_STORE_ALIGNMENT-aligned block of
+// entity_store_block_size(capacity) bytes without touching its contents.
+// count and free_id_count come from wherever the block was saved. Fails
+// unless the ids, id_to_index and free_ids arrays are consistent, so a
+// corrupt block cannot send lookups out of bounds. The store never frees the
+// block.
+bool entity_store_attach(EntityStore& store, int capacity, int count, int free_id_count, void* block);
+// The id arrays of a block from elsewhere index each other, so they must
+// agree before anything follows them: every live id is in range and maps back
+// to its index, every free id is in range and unmapped, and live plus free
+// ids use each id exactly once.
+bool entity_store_ids_consistent(const EntityStore& store);
+void entity_store_clear(EntityStore& store);
+
+// Returns the dense index of the new entity, or -1 if the store is full.
+int entity_store_spawn(EntityStore& store, float x, float y, int team);
+// Removes the entity at a dense index by swapping the last entity into it.
+bool entity_store_despawn(EntityStore& store, int index);
+// Returns the dense index for a stable id, or -1 if it is not alive.
+int entity_store_index_of(const EntityStore& store, uint32_t id);
+
+#endif
@@ -0,0 +1,275 @@
+#include "flow_field.h"
+#include <algorithm>
+
+const int flow_direction_dx[8] = { 1, 1, 0, -1, -1, -1, 0, 1 };
+const int flow_direction_dy[8] = { 0, 1, 1, 1, 0, -1, -1, -1 };
+
+// Integer step weights, so the wavefront can use one bucket per value
+#define FLOW_STEP_STRAIGHT 10
+#define FLOW_STEP_DIAGONAL 14
+// Larger than the dearest single step (254 * 14), so a circular array of
+// buckets never holds two different values at once
+#define FLOW_BUCKETS 4096
+
+void flow_field_init(FlowField& field, float world_bounds, float cell_size) {
+    field.origin = -world_bounds;
+    field.cells_per_side = std::max(1, (int)ceilf(world_bounds * 2.0f / cell_size));
+    field.cell_size = cell_size;
+    field.inv_cell_size = 1.0f / cell_size;
+    const int cells = field.cells_per_side * field.cells_per_side;
+    field.cost.assign(cells, 1);
+    for (int t = 0; t < FLOW_MAX_TEAMS; t++) {
+        FlowTeam& team = field.teams[t];
+        team.integration.assign(cells, FLOW_UNREACHABLE);
+        team.direction.assign(cells, FLOW_NO_DIRECTION);
+        team.goal.assign(cells, 0);
+        team.goal_count = 0;
+        team.raised.clear();
+        team.lowered.clear();
+        team.buckets.resize(FLOW_BUCKETS);
+        team.cleared.assign(cells, 0);
+        team.last_update_cells = 0;
+    }
+}
+
+void flow_field_set_cost(FlowField& field, int cell, uint8_t cost) {
+    if (cost == 0) cost = 1;
+    const uint8_t old = field.cost[cell];
+    if (cost == old) return;
+    field.cost[cell] = cost;
+    for (int t = 0; t < FLOW_MAX_TEAMS; t++) {
+        FlowTeam& team = field.teams[t];
+        (cost > old ? team.raised : team.lowered).push_back(cell);
+    }
+}
+
+void flow_field_set_goal(FlowField& field, int team_index, int cell, bool is_goal) {
+    FlowTeam& team = field.teams[team_index];
+    if ((team.goal[cell] != 0) == is_goal) return;
+    team.goal[cell] = is_goal ? 1 : 0;
+    team.goal_count += is_goal ? 1 : -1;
+    (is_goal ? team.lowered : team.raised).push_back(cell);
+}
+
+void flow_field_clear_goals(FlowField& field, int team_index) {
+    FlowTeam& team = field.teams[team_index];
+    const int cells = (int)team.goal.size();
+    for (int c = 0; c < cells && team.goal_count > 0; c++) {
+        if (team.goal[c]) flow_field_set_goal(field, team_index, c, false);
+    }
+}
+
+bool flow_field_team_pending(const FlowField& field, int team) {
+    return !field.teams[team].raised.empty() || !field.teams[team].lowered.empty();
+}
+
+// Whether an agent in (cx, cy) can step in direction d: the target is inside
+// and open, and a diagonal step does not cut the corner of a blocked cell
+static inline bool step_allowed(const FlowField& field, int cx, int cy, int d) {
+    const int n = field.cells_per_side;
+    const int tx = cx + flow_direction_dx[d];
+    const int ty = cy + flow_direction_dy[d];
+    if (tx < 0 || ty < 0 || tx >= n || ty >= n) return false;
+    const uint8_t* cost = field.cost.data();
+    if (cost[ty * n + tx] == FLOW_BLOCKED) return false;
+    if (d & 1) {
+        if (cost[cy * n + tx] == FLOW_BLOCKED || cost[ty * n + cx] == FLOW_BLOCKED) return false;
+    }
+    return true;
+}
+
+static inline uint32_t step_cost(const FlowField& field, int cell, int d) {
+    return (uint32_t)field.cost[cell] * ((d & 1) ? FLOW_STEP_DIAGONAL : FLOW_STEP_STRAIGHT);
+}
+
+// Cheapest value a cell can take from its neighbours' current values, and
+// the direction it is reached through
+static uint32_t best_from_neighbours(const FlowField& field, const FlowTeam& team, int cell, int* direction) {
+    *direction = FLOW_NO_DIRECTION;
+    if (field.cost[cell] == FLOW_BLOCKED) return FLOW_UNREACHABLE;
+    if (team.goal[cell]) return 0;
+    const int n = field.cells_per_side;
+    const int cx = cell % n;
+    const int cy = cell / n;
+    uint32_t best = FLOW_UNREACHABLE;
+    for (int d = 0; d < 8; d++) {
+        if (!step_allowed(field, cx, cy, d)) continue;
+        const uint32_t next = team.integration[(cy + flow_direction_dy[d]) * n + cx + flow_direction_dx[d]];
+        if (next == FLOW_UNREACHABLE) continue;
+        const uint32_t value = next + step_cost(field, cell, d);
+        if (value < best) {
+            best = value;
+            *direction = d;
+        }
+    }
+    return best;
+}
+
+// Lowers a cell to value if that is an improvement and queues it as a seed
+static inline void seed(FlowTeam& team, int cell, uint32_t value, int direction) {
+    if (value >= team.integration[cell]) return;
+    team.integration[cell] = value;
+    team.direction[cell] = (uint8_t)direction;
+    team.seeds.push_back(((uint64_t)value << 32) | (uint32_t)cell);
+}
+
+// Dijkstra from the seeds. Values only ever fall, and a cell is settled when
+// the wavefront reaches its value, at which point it offers itself to every
+// neighbour that can step into it.
+static void run_wavefront(const FlowField& field, FlowTeam& team) {
+    const int n = field.cells_per_side;
+    const uint8_t* cost = field.cost.data();
+    uint32_t* integration = team.integration.data();
+    uint8_t* direction = team.direction.data();
+
+    std::sort(team.seeds.begin(), team.seeds.end());
+    const size_t seed_count = team.seeds.size();
+    size_t next_seed = 0;
+    int pending = 0;
+    int settled = 0;
+    uint32_t current = 0;
+    while (pending > 0 || next_seed < seed_count) {
+        if (pending == 0) current = (uint32_t)(team.seeds[next_seed] >> 32);
+        std::vector<int32_t>& bucket = team.buckets[current & (FLOW_BUCKETS - 1)];
+        // Seeds join when the wavefront reaches their value
+        for (; next_seed < seed_count && (uint32_t)(team.seeds[next_seed] >> 32) == current; next_seed++) {
+            bucket.push_back((int32_t)(uint32_t)team.seeds[next_seed]);
+            pending++;
+        }
+        // Every step costs at least FLOW_STEP_STRAIGHT, so nothing pushed
+        // while draining lands back in this bucket
+        for (size_t i = 0; i < bucket.size(); i++) {
+            const int c = bucket[i];
+            pending--;
+            if (integration[c] != current) continue; // superseded by a cheaper entry
+            settled++;
+            const int cx = c % n;
+            const int cy = c / n;
+            for (int d = 0; d < 8; d++) {
+                const int mx = cx + flow_direction_dx[d];
+                const int my = cy + flow_direction_dy[d];
+                if (mx < 0 || my < 0 || mx >= n || my >= n) continue;
+                const int m = my * n + mx;
+                if (cost[m] == FLOW_BLOCKED) continue;
+                // m steps back towards c, the opposite direction
+                const int back = (d + 4) & 7;
+                if ((back & 1) && (cost[my * n + cx] == FLOW_BLOCKED || cost[cy * n + mx] == FLOW_BLOCKED)) continue;
+                const uint32_t value = current + step_cost(field, m, back);
+                if (value < integration[m]) {
+                    integration[m] = value;
+                    direction[m] = (uint8_t)back;
+                    team.buckets[value & (FLOW_BUCKETS - 1)].push_back(m);
+                    pending++;
+                }
+            }
+        }
+        bucket.clear();
+        current++;
+    }
+    team.seeds.clear();
+    team.last_update_cells = settled;
+}
+
+void flow_field_update_team(FlowField& field, int team_index) {
+    FlowTeam& team = field.teams[team_index];
+    team.last_update_cells = 0;
+    if (team.raised.empty() && team.lowered.empty()) return;
+    const int n = field.cells_per_side;
+    team.seeds.clear();
+
+    if (!team.raised.empty()) {
+        // Clear the raised cells and everything downstream of them: cells
+        // whose direction leads into a cleared cell, plus cells whose
+        // diagonal step squeezed past a cell that may now be blocked
+        team.stack.clear();
+        for (int r : team.raised) {
+            if (!team.cleared[r]) {
+                team.cleared[r] = 1;
+                team.stack.push_back(r);
+            }
+            const int rx = r % n;
+            const int ry = r / n;
+            for (int d = 1; d < 8; d += 2) {
+                // The two diagonal neighbours of r whose step in direction d
+                // passes r's corner sit beside r along each axis
+                const int ax = rx - flow_direction_dx[d];
+                const int by = ry - flow_direction_dy[d];
+                if (ax >= 0 && ax < n) {
+                    const int a = ry * n + ax;
+                    if (team.direction[a] == d && !team.cleared[a]) {
+                        team.cleared[a] = 1;
+                        team.stack.push_back(a);
+                    }
+                }
+                if (by >= 0 && by < n) {
+                    const int b = by * n + rx;
+                    if (team.direction[b] == d && !team.cleared[b]) {
+                        team.cleared[b] = 1;
+                        team.stack.push_back(b);
+                    }
+                }
+            }
+        }
+        for (size_t i = 0; i < team.stack.size(); i++) {
+            const int c = team.stack[i];
+            const int cx = c % n;
+            const int cy = c / n;
+            for (int d = 0; d < 8; d++) {
+                const int mx = cx + flow_direction_dx[d];
+                const int my = cy + flow_direction_dy[d];
+                if (mx < 0 || my < 0 || mx >= n || my >= n) continue;
+                const int m = my * n + mx;
+                if (!team.cleared[m] && team.direction[m] == ((d + 4) & 7)) {
+                    team.cleared[m] = 1;
+                    team.stack.push_back(m);
+                }
+            }
+        }
+        for (int c : team.stack) {
+            team.integration[c] = FLOW_UNREACHABLE;
+            team.direction[c] = FLOW_NO_DIRECTION;
+        }
+        // Refill from the edge of the cleared region; interior cells are
+        // reached by the wavefront
+        for (int c : team.stack) {
+            int direction;
+            const uint32_t value = best_from_neighbours(field, team, c, &direction);
+            if (value != FLOW_UNREACHABLE) seed(team, c, value, direction);
+            team.cleared[c] = 0;
+        }
+    }
+
+    // A cheaper cell can only improve its own value, but a cell that opened
+    // up also unblocks diagonal steps around it, so its neighbours are
+    // re-evaluated too
+    for (int c : team.lowered) {
+        const int cx = c % n;
+        const int cy = c / n;
+        for (int y = std::max(0, cy - 1); y <= std::min(n - 1, cy + 1); y++) {
+            for (int x = std::max(0, cx - 1); x <= std::min(n - 1, cx + 1); x++) {
+                int direction;
+                const int e = y * n + x;
+                const uint32_t value = best_from_neighbours(field, team, e, &direction);
+                seed(team, e, value, direction);
+            }
+        }
+    }
+
+    team.raised.clear();
+    team.lowered.clear();
+    run_wavefront(field, team);
+}
+
+void flow_field_rebuild_team(FlowField& field, int team_index) {
+    FlowTeam& team = field.teams[team_index];
+    std::fill(team.integration.begin(), team.integration.end(), FLOW_UNREACHABLE);
+    std::fill(team.direction.begin(), team.direction.end(), (uint8_t)FLOW_NO_DIRECTION);
+    team.raised.clear();
+    team.lowered.clear();
+    team.seeds.clear();
+    const int cells = (int)team.goal.size();
+    for (int c = 0; c < cells; c++) {
+        if (team.goal[c] && field.cost[c] != FLOW_BLOCKED) seed(team, c, 0, FLOW_NO_DIRECTION);
+    }
+    run_wavefront(field, team);
+}
@@ -0,0 +1,104 @@
+#ifndef FLOW_FIELD_H
+#define FLOW_FIELD_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Flow-field navigation over a square grid covering the world. Cells have a
+// traversal cost shared by all teams (FLOW_BLOCKED for obstacles). Each team
+// has its own goal cells, an integration field (cheapest cost to reach a goal,
+// 8-connected, diagonals cost 14/10 and never cut a blocked corner) and a
+// direction field pointing every cell at its next cell on that path, so an
+// agent finds its heading with one lookup whatever the population.
+//
+// Fields are built with a bucketed Dijkstra wavefront (integer costs, so a
+// bucket per cost value and no heap). Goal and cost changes are queued and
+// applied by flow_field_update_team, which only revisits the cells they affect:
+// cheaper cells and new goals seed the wavefront from themselves, while
+// dearer cells, new obstacles and removed goals first clear every cell whose
+// path ran through them (found by walking the direction field backwards) and
+// refill that region from its edges. Work grows with the changed region, not
+// with the grid or the number of agents.
+
+#define FLOW_MAX_TEAMS 4
+#define FLOW_BLOCKED 255
+#define FLOW_UNREACHABLE 0xFFFFFFFFu
+#define FLOW_NO_DIRECTION 8 // goals, obstacles and cells that cannot reach a goal
+
+struct FlowTeam {
+    std::vector<uint32_t> integration;
+    std::vector<uint8_t> direction; // 0-7, see flow_field_direction_vector
+    std::vector<uint8_t> goal;
+    int goal_count;
+
+    // Changes since the last update
+    std::vector<int32_t> raised;  // may have got dearer to reach a goal from
+    std::vector<int32_t> lowered; // may have got cheaper
+
+    // Update scratch, kept between updates so steady state does not allocate
+    std::vector<std::vector<int32_t>> buckets;
+    std::vector<uint64_t> seeds; // value << 32 | cell
+    std::vector<int32_t> stack;
+    std::vector<uint8_t> cleared;
+    int last_update_cells; // cells the last update settled
+};
+
+struct FlowField {
+    float origin; // world coordinate of the first cell edge (-bounds)
+    float cell_size;
+    float inv_cell_size;
+    int cells_per_side;
+    std::vector<uint8_t> cost; // 1-254, or FLOW_BLOCKED
+    FlowTeam teams[FLOW_MAX_TEAMS];
+};
+
+// Covers [-bounds, bounds] with cells of cell_size, all of cost 1, no goals
+void flow_field_init(FlowField& field, float world_bounds, float cell_size);
+
+// Cell under a world position, clamped into the grid
+static inline int flow_field_cell(const FlowField& field, float x, float y) {
+    int n = field.cells_per_side;
+    int cx = (int)floorf((x - field.origin) * field.inv_cell_size);
+    int cy = (int)floorf((y - field.origin) * field.inv_cell_size);
+    cx = cx < 0 ? 0 : (cx >= n ? n - 1 : cx);
+    cy = cy < 0 ? 0 : (cy >= n ? n - 1 : cy);
+    return cy * n + cx;
+}
+
+// Queue changes; nothing is recomputed until flow_field_update_team
+void flow_field_set_cost(FlowField& field, int cell, uint8_t cost);
+void flow_field_set_goal(FlowField& field, int team, int cell, bool is_goal);
+void flow_field_clear_goals(FlowField& field, int team);
+
+// Applies the queued changes of one team. Teams are independent, so
+// different teams can update in parallel.
+void flow_field_update_team(FlowField& field, int team);
+bool flow_field_team_pending(const FlowField& field, int team);
+
+// Discards a team's fields and rebuilds them from its goals with a full
+// wavefront over the grid, for checking the incremental path
+void flow_field_rebuild_team(FlowField& field, int team);
+
+// Direction d steps to the cell (x + flow_direction_dx[d], y + flow_direction_dy[d]);
+// odd directions are diagonal
+extern const int flow_direction_dx[8];
+extern const int flow_direction_dy[8];
+
+// Unit vector of a direction index
+static inline void flow_field_direction_vector(int direction, float* dir_x, float* dir_y) {
+    const float s = (direction & 1) ? 0.70710678f : 1.0f;
+    *dir_x = (float)flow_direction_dx[direction] * s;
+    *dir_y = (float)flow_direction_dy[direction] * s;
+}
+
+// Heading for an agent of the team at (x, y). False at goals, in obstacles
+// and where no goal can be reached.
+static inline bool flow_field_sample(const FlowField& field, int team, float x, float y, float* dir_x, float* dir_y) {
+    int direction = field.teams[team].direction[flow_field_cell(field, x, y)];
+    if (direction == FLOW_NO_DIRECTION) return false;
+    flow_field_direction_vector(direction, dir_x, dir_y);
+    return true;
+}
+
+#endif
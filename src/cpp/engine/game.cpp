@@ -1,92 +1,483 @@
 #include "game.h"
-#include <cstdlib> // for rand()
-#include <cmath>  // for sin, cos
+#include "world.h"
+#include "entity_store.h"
+#include "job_system.h"
+#include "spatial_grid.h"
+#include "culling.h"
+#include "profiler.h"
+#include "worker_thread.h"
+#include "world_file.h"
+#include <atomic>
+#include <vector>
 
-static AIEntity g_ai_entities[NUM_AI_ENTITIES];
-static float g_ai_speed = 150.0f; // pixels per second
-static float g_world_bounds = 1000.0f; // world size
+// The world behind the C API. Everything but async publishing and view
+// culling lives in world.cpp.
+static World g_world;
+static SimSnapshot g_snapshot;
 
-// Simple random number generator (0.0 to 1.0)
-float random_float() {
-    return (float)rand() / (float)RAND_MAX;
+static CullBuffers g_view_cull_buffers[NUM_AI_ENTITIES];
+static ViewCull g_view_culls[NUM_AI_ENTITIES];
+
+// Async mode: the next step runs on the worker thread while the main thread
+// renders the last completed one. Each finished step is published into the
+// back state, and begin_game_step makes it the front with one atomic swap.
+// The worker only ever writes the back state and the main thread only reads
+// the front, and the swap happens after the worker has been joined.
+struct PublishedState {
+    std::vector<float> x, y, prev_x, prev_y;
+    std::vector<int32_t> team;
+    std::vector<uint32_t> id;
+    int count;
+    float alpha;
+    float camera_x[NUM_AI_ENTITIES]; // render positions of the followed ids 0-3
+    float camera_y[NUM_AI_ENTITIES];
+    SpatialGrid grid;
+    SimSnapshot snapshot;
+};
+
+static PublishedState g_published[2];
+static std::atomic<int> g_front_state(0);
+static bool g_async = false;
+static bool g_step_in_flight = false; // worker is running a step into the back state
+static bool g_back_ready = false;     // back state holds a finished step not yet swapped in
+static float g_pending_frame_time = 0.0f;
+
+// Join the in-flight async step, if any, before touching the live world
+static void finish_step() {
+    if (g_step_in_flight) {
+        worker_thread_wait();
+        g_step_in_flight = false;
+        g_back_ready = true;
+    }
+}
+
+static float render_position(float prev, float current, float alpha) {
+    return alpha < 1.0f ? prev + (current - prev) * alpha : current;
+}
+
+// Copy the live world into a published state. Vectors keep their capacity,
+// so once warmed up this does not allocate.
+static void publish_state(PublishedState& state) {
+    const EntityStore& entities = g_world.entities;
+    int count = entities.count;
+    state.x.assign(entities.x, entities.x + count);
+    state.y.assign(entities.y, entities.y + count);
+    state.prev_x.assign(entities.prev_x, entities.prev_x + count);
+    state.prev_y.assign(entities.prev_y, entities.prev_y + count);
+    state.team.assign(entities.team, entities.team + count);
+    state.id.assign(entities.id, entities.id + count);
+    state.count = count;
+    state.alpha = g_world.interpolation_alpha;
+
+    for (int i = 0; i < NUM_AI_ENTITIES; i++) {
+        int index = entity_store_index_of(entities, (uint32_t)i);
+        state.camera_x[i] = index >= 0 ? render_position(entities.prev_x[index], entities.x[index], state.alpha) : 0.0f;
+        state.camera_y[i] = index >= 0 ? render_position(entities.prev_y[index], entities.y[index], state.alpha) : 0.0f;
+    }
+
+    world_ensure_spatial_grid(g_world);
+    spatial_grid_copy(state.grid, g_world.spatial_grid);
+
+    state.snapshot.x = state.x.data();
+    state.snapshot.y = state.y.data();
+    state.snapshot.team = state.team.data();
+    state.snapshot.id = state.id.data();
+    state.snapshot.count = count;
+    state.snapshot.stride = (int32_t)sizeof(float);
+}
+
+// After the entity set was replaced wholesale, in async mode a published
+// state for the renderer to start from
+static void world_replaced() {
+    if (g_async) {
+        publish_state(g_published[g_front_state.load(std::memory_order_relaxed)]);
+        g_back_ready = false;
+    }
+}
+
+// Worker thread task: one frame's worth of steps, published into the back state
+static void step_task(void* user_data) {
+    (void)user_data;
+    world_advance(g_world, g_pending_frame_time);
+    publish_state(g_published[1 - g_front_state.load(std::memory_order_acquire)]);
 }
 
 extern "C" {
-    void init_game() {
-        // Initialize AI entities at different starting positions
-        static float start_positions[4][2] = {
-            {-200.0f, -200.0f}, // Red team
-            {200.0f, -200.0f},  // Blue team
-            {-200.0f, 200.0f},  // Purple team
-            {200.0f, 200.0f}    // Brown team
-        };
-
-        for (int i = 0; i < NUM_AI_ENTITIES; i++) {
-            g_ai_entities[i].x = start_positions[i][0];
-            g_ai_entities[i].y = start_positions[i][1];
-            g_ai_entities[i].vx = 0.0f;
-            g_ai_entities[i].vy = 0.0f;
-            g_ai_entities[i].team = (TeamColor)i;
-            g_ai_entities[i].move_timer = 0.0f;
-        }
+    void init_game(int max_entities, int initial_entities) {
+        finish_step();
+        if (world_init(g_world, max_entities, initial_entities)) world_replaced();
+    }
+
+    int get_world_snapshot_size() {
+        finish_step();
+        return g_world.entities.block ? (int)world_file_size(g_world.entities.capacity) : 0;
+    }
+
+    int write_world_snapshot(void* out, int size) {
+        finish_step();
+        world_lod_sync(g_world);
+        if (!g_world.entities.block || size < (int)world_file_size(g_world.entities.capacity)) return 0;
+
+        WorldFileHeader header;
+        world_fill_header(g_world, header);
+        world_file_serialize(header, g_world.entities.block, out);
+        return 1;
+    }
+
+    void start_replay_recording(int keyframe_interval) {
+        finish_step();
+        world_start_replay(g_world, keyframe_interval);
+    }
+
+    void stop_replay_recording() {
+        finish_step();
+        g_world.replay_recording = false;
+    }
+
+    const uint8_t* get_replay_data() {
+        finish_step();
+        return g_world.replay.bytes.data();
+    }
+
+    int get_replay_size() {
+        finish_step();
+        return (int)g_world.replay.bytes.size();
+    }
+
+    void* alloc_world_buffer(int size) {
+        finish_step();
+        return world_alloc_buffer(g_world, size);
+    }
 
-        // Seed random number generator
-        srand(42); // Fixed seed for reproducible behavior
+    int load_world_from_memory(void* data, int size) {
+        finish_step();
+        const WorldFileHeader* header = size > 0 ? world_file_validate(data, (size_t)size) : nullptr;
+        if (!world_attach(g_world, header, data)) return 0;
+        world_replaced();
+        return 1;
     }
 
+#ifndef __EMSCRIPTEN__
+    int save_world(const char* path) {
+        finish_step();
+        return world_save(g_world, path) ? 1 : 0;
+    }
+
+    int load_world(const char* path) {
+        finish_step();
+        if (!world_load(g_world, path)) return 0;
+        world_replaced();
+        return 1;
+    }
+#endif
+
     void update_game(float delta_time) {
-        for (int i = 0; i < NUM_AI_ENTITIES; i++) {
-            AIEntity& ai = g_ai_entities[i];
-
-            // Update movement timer
-            ai.move_timer -= delta_time;
-
-            // Change direction randomly every 1-3 seconds
-            if (ai.move_timer <= 0.0f) {
-                // Random direction (0-360 degrees)
-                float angle = random_float() * 6.283185f; // 2 * PI
-                float speed = g_ai_speed * (0.5f + random_float() * 0.5f); // 50-100% of base speed
-
-                ai.vx = cos(angle) * speed;
-                ai.vy = sin(angle) * speed;
-
-                // Reset timer (1-3 seconds)
-                ai.move_timer = 1.0f + random_float() * 2.0f;
-            }
-
-            // Update position
-            ai.x += ai.vx * delta_time;
-            ai.y += ai.vy * delta_time;
-
-            // Keep entities within world bounds (bounce off edges)
-            if (ai.x < -g_world_bounds || ai.x > g_world_bounds) {
-                ai.vx = -ai.vx;
-                ai.x = ai.x < -g_world_bounds ? -g_world_bounds : g_world_bounds;
-            }
-            if (ai.y < -g_world_bounds || ai.y > g_world_bounds) {
-                ai.vy = -ai.vy;
-                ai.y = ai.y < -g_world_bounds ? -g_world_bounds : g_world_bounds;
-            }
+        PROFILE_SCOPE(PROFILE_SIM);
+        finish_step();
+        world_step(g_world, delta_time);
+    }
+
+    float advance_game(float frame_time) {
+        PROFILE_SCOPE(PROFILE_SIM);
+        finish_step();
+        return world_advance(g_world, frame_time);
+    }
+
+    void set_async_simulation(int enabled) {
+        finish_step();
+        g_back_ready = false;
+        g_async = enabled != 0 && worker_thread_available();
+        if (g_async) {
+            publish_state(g_published[g_front_state.load(std::memory_order_relaxed)]);
         }
     }
 
+    int get_async_simulation() {
+        return g_async ? 1 : 0;
+    }
+
+    void begin_game_step(float frame_time) {
+        // Async, this is only the time spent waiting on the worker
+        PROFILE_SCOPE(PROFILE_SIM);
+
+        if (!g_async) {
+            world_advance(g_world, frame_time);
+            return;
+        }
+
+        // The step started last frame becomes what this frame renders
+        finish_step();
+        if (g_back_ready) {
+            g_front_state.store(1 - g_front_state.load(std::memory_order_relaxed), std::memory_order_release);
+            g_back_ready = false;
+        }
+
+        g_pending_frame_time = frame_time;
+        g_step_in_flight = true;
+        worker_thread_start(step_task, nullptr);
+    }
+
+    void finish_game_step() {
+        finish_step();
+    }
+
+    void set_fixed_timestep(float ticks_per_second, int max_steps_per_frame) {
+        finish_step();
+        world_set_fixed_timestep(g_world, ticks_per_second, max_steps_per_frame);
+    }
+
+    float get_interpolation_alpha() {
+        if (g_async) return g_published[g_front_state.load(std::memory_order_acquire)].alpha;
+        return g_world.interpolation_alpha;
+    }
+
+    uint32_t get_game_tick() {
+        finish_step();
+        return g_world.tick;
+    }
+
+    void set_worker_count(int num_workers) {
+        finish_step();
+        job_system_init(num_workers);
+    }
+
+    void set_game_seed(int seed) {
+        finish_step();
+        g_world.seed = (uint32_t)seed;
+    }
+
+    int spawn_ai(float x, float y, int team) {
+        finish_step();
+        return world_spawn(g_world, x, y, team);
+    }
+
+    int despawn_ai(int ai_index) {
+        finish_step();
+        return world_despawn(g_world, ai_index) ? 1 : 0;
+    }
+
+    void set_spatial_cell_size(float cell_size) {
+        finish_step();
+        g_world.spatial_cell_size = cell_size;
+    }
+
+    void set_world_bounds(float world_bounds) {
+        finish_step();
+        if (world_bounds > 0.0f) g_world.world_bounds = world_bounds;
+    }
+
+    void set_collisions(int enabled) {
+        finish_step();
+        g_world.collisions = enabled != 0;
+        g_world.collision_contacts = 0;
+    }
+
+    int get_collisions() {
+        return g_world.collisions ? 1 : 0;
+    }
+
+    int get_collision_contacts() {
+        finish_step();
+        return g_world.collision_contacts;
+    }
+
+    void set_ai_behaviour(int behaviour) {
+        finish_step();
+        g_world.ai_behaviour = behaviour == AI_BEHAVIOUR_FLOCK ? AI_BEHAVIOUR_FLOCK : AI_BEHAVIOUR_RANDOM_WALK;
+    }
+
+    int get_ai_behaviour() {
+        return g_world.ai_behaviour;
+    }
+
+    void set_steering_weights(float separation, float alignment, float cohesion, float avoidance) {
+        finish_step();
+        g_world.steering.separation = separation;
+        g_world.steering.alignment = alignment;
+        g_world.steering.cohesion = cohesion;
+        g_world.steering.avoidance = avoidance;
+    }
+
+    void set_flow_cell_size(float cell_size) {
+        finish_step();
+        if (cell_size > 0.0f) g_world.flow_cell_size = cell_size;
+    }
+
+    int add_team_goal(int team, float x, float y) {
+        finish_step();
+        FlowField& flow = g_world.flow;
+        if (team < 0 || team >= FLOW_MAX_TEAMS || flow.cost.empty()) return 0;
+        flow_field_set_goal(flow, team, flow_field_cell(flow, x, y), true);
+        return 1;
+    }
+
+    void clear_team_goals(int team) {
+        finish_step();
+        if (team < 0 || team >= FLOW_MAX_TEAMS || g_world.flow.cost.empty()) return;
+        flow_field_clear_goals(g_world.flow, team);
+    }
+
+    void set_flow_cost(float min_x, float min_y, float max_x, float max_y, int cost) {
+        finish_step();
+        world_set_flow_cost(g_world, min_x, min_y, max_x, max_y, cost);
+    }
+
+    void set_simulation_lod(int enabled) {
+        finish_step();
+        g_world.lod_enabled = enabled != 0;
+        if (!g_world.lod_enabled) world_lod_sync(g_world);
+    }
+
+    int get_simulation_lod() {
+        return g_world.lod_enabled ? 1 : 0;
+    }
+
+    void set_lod_tiers(float near_radius, float far_radius, int mid_interval, int far_interval) {
+        finish_step();
+        LodParams& lod = g_world.lod;
+        lod.radius[0] = near_radius;
+        lod.radius[1] = far_radius > near_radius ? far_radius : near_radius;
+        lod.interval[1] = lod_interval(mid_interval);
+        lod.interval[2] = lod_interval(far_interval);
+    }
+
+    int get_lod_tier_count(int tier) {
+        finish_step();
+        return world_lod_tier_count(g_world, tier);
+    }
+
+    int query_ai_radius(float x, float y, float radius, int* out_indices, int max_out) {
+        finish_step();
+        world_ensure_spatial_grid(g_world);
+        return spatial_grid_query_radius(g_world.spatial_grid, g_world.entities.x, g_world.entities.y, x, y, radius,
+                                         (int32_t*)out_indices, max_out);
+    }
+
+    int query_ai_aabb(float min_x, float min_y, float max_x, float max_y, int* out_indices, int max_out) {
+        finish_step();
+        world_ensure_spatial_grid(g_world);
+        return spatial_grid_query_aabb(g_world.spatial_grid, g_world.entities.x, g_world.entities.y,
+                                       min_x, min_y, max_x, max_y, (int32_t*)out_indices, max_out);
+    }
+
+    const ViewCull* cull_ai_view(int viewport_index, float center_x, float center_y,
+                                 float half_width, float half_height) {
+        if (viewport_index < 0 || viewport_index >= NUM_AI_ENTITIES) return nullptr;
+        PROFILE_SCOPE(PROFILE_CULL);
+
+        ViewCull& cull = g_view_culls[viewport_index];
+        float min_x = center_x - half_width, min_y = center_y - half_height;
+        float max_x = center_x + half_width, max_y = center_y + half_height;
+
+        // Async mode culls the last published step while the next one runs
+        if (g_async) {
+            const PublishedState& state = g_published[g_front_state.load(std::memory_order_acquire)];
+            bool interpolate = state.alpha < 1.0f;
+            float max_travel = interpolate ? world_step_max_travel(g_world) : 0.0f;
+            cull_view(g_view_cull_buffers[viewport_index], cull, state.grid,
+                      state.x.data(), state.y.data(), state.team.data(),
+                      interpolate ? state.prev_x.data() : nullptr, interpolate ? state.prev_y.data() : nullptr,
+                      state.alpha, max_travel, min_x, min_y, max_x, max_y);
+            return &cull;
+        }
+
+        world_ensure_spatial_grid(g_world);
+
+        // Between fixed steps the view shows interpolated positions, which are
+        // at most one step's travel from where the grid has them
+        const EntityStore& entities = g_world.entities;
+        float alpha = g_world.interpolation_alpha;
+        bool interpolate = alpha < 1.0f;
+        float max_travel = interpolate ? world_step_max_travel(g_world) : 0.0f;
+
+        cull_view(g_view_cull_buffers[viewport_index], cull, g_world.spatial_grid,
+                  entities.x, entities.y, entities.team,
+                  interpolate ? entities.prev_x : nullptr, interpolate ? entities.prev_y : nullptr,
+                  alpha, max_travel, min_x, min_y, max_x, max_y);
+        return &cull;
+    }
+
+    float get_camera_x(int viewport_index) {
+        if (viewport_index < 0 || viewport_index >= NUM_AI_ENTITIES) return 0.0f;
+        if (g_async) return g_published[g_front_state.load(std::memory_order_acquire)].camera_x[viewport_index];
+        return get_ai_render_x(get_ai_index(viewport_index));
+    }
+
+    float get_camera_y(int viewport_index) {
+        if (viewport_index < 0 || viewport_index >= NUM_AI_ENTITIES) return 0.0f;
+        if (g_async) return g_published[g_front_state.load(std::memory_order_acquire)].camera_y[viewport_index];
+        return get_ai_render_y(get_ai_index(viewport_index));
+    }
+
+    int get_ai_count() {
+        finish_step();
+        return g_world.entities.count;
+    }
+
+    int get_ai_index(int ai_id) {
+        if (ai_id < 0) return -1;
+        finish_step();
+        return entity_store_index_of(g_world.entities, (uint32_t)ai_id);
+    }
+
+    int get_ai_id(int ai_index) {
+        finish_step();
+        if (ai_index >= 0 && ai_index < g_world.entities.count) {
+            return (int)g_world.entities.id[ai_index];
+        }
+        return -1;
+    }
+
+    const SimSnapshot* get_sim_snapshot() {
+        if (g_async) return &g_published[g_front_state.load(std::memory_order_acquire)].snapshot;
+
+        g_snapshot.x = g_world.entities.x;
+        g_snapshot.y = g_world.entities.y;
+        g_snapshot.team = g_world.entities.team;
+        g_snapshot.id = g_world.entities.id;
+        g_snapshot.count = g_world.entities.count;
+        g_snapshot.stride = (int32_t)sizeof(float);
+        return &g_snapshot;
+    }
+
     float get_ai_x(int ai_index) {
-        if (ai_index >= 0 && ai_index < NUM_AI_ENTITIES) {
-            return g_ai_entities[ai_index].x;
+        finish_step();
+        if (ai_index >= 0 && ai_index < g_world.entities.count) {
+            return g_world.entities.x[ai_index];
         }
         return 0.0f;
     }
 
     float get_ai_y(int ai_index) {
-        if (ai_index >= 0 && ai_index < NUM_AI_ENTITIES) {
-            return g_ai_entities[ai_index].y;
+        finish_step();
+        if (ai_index >= 0 && ai_index < g_world.entities.count) {
+            return g_world.entities.y[ai_index];
+        }
+        return 0.0f;
+    }
+
+    float get_ai_render_x(int ai_index) {
+        finish_step();
+        if (ai_index >= 0 && ai_index < g_world.entities.count) {
+            return render_position(g_world.entities.prev_x[ai_index], g_world.entities.x[ai_index],
+                                   g_world.interpolation_alpha);
+        }
+        return 0.0f;
+    }
+
+    float get_ai_render_y(int ai_index) {
+        finish_step();
+        if (ai_index >= 0 && ai_index < g_world.entities.count) {
+            return render_position(g_world.entities.prev_y[ai_index], g_world.entities.y[ai_index],
+                                   g_world.interpolation_alpha);
         }
         return 0.0f;
     }
 
     int get_ai_team(int ai_index) {
-        if (ai_index >= 0 && ai_index < NUM_AI_ENTITIES) {
-            return (int)g_ai_entities[ai_index].team;
+        finish_step();
+        if (ai_index >= 0 && ai_index < g_world.entities.count) {
+            return (int)g_world.entities.team[ai_index];
         }
         return 0;
     }
@@ -1,7 +1,9 @@
 #ifndef GAME_H
 #define GAME_H
 
-#define NUM_AI_ENTITIES 4
+#include <stdint.h>
+
+#define NUM_AI_ENTITIES 4 // entities followed by the split-screen cameras
 
 enum TeamColor {
     TEAM_RED = 0,
@@ -10,22 +12,173 @@ enum TeamColor {
     TEAM_BROWN = 3
 };
 
-struct AIEntity {
-    float x, y;
-    float vx, vy; // velocity components
-    TeamColor team;
-    float move_timer; // timer for random movement changes
+// Read-only view of the packed entity arrays, valid until the next
+// init_game/spawn_ai/despawn_ai. Each array holds count elements, stride bytes
+// apart. In the WASM build the struct is six 32-bit words (x, y, team, id,
+// count, stride), so JS can read it from HEAPU32 and wrap the arrays in
+// typed-array views without copying.
+struct SimSnapshot {
+    const float* x;
+    const float* y;
+    const int32_t* team;
+    const uint32_t* id;
+    int32_t count;
+    int32_t stride;
+};
+
+// How entities choose their velocity
+enum AiBehaviour {
+    AI_BEHAVIOUR_RANDOM_WALK = 0, // a new random direction every 1-3 seconds
+    AI_BEHAVIOUR_FLOCK = 1        // the random walk, steered every step by nearby entities
 };
 
+struct ViewCull; // culling.h
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-void init_game();
+// Sizes the entity store for max_entities and spawns initial_entities.
+// The first NUM_AI_ENTITIES get the fixed team start positions (ids 0-3),
+// the rest are scattered across the world.
+void init_game(int max_entities, int initial_entities);
+// One simulation step of delta_time seconds
 void update_game(float delta_time);
+// Per-frame entry point. In fixed-timestep mode runs as many whole steps as
+// the accumulated frame time allows (at most max_steps_per_frame, dropping any
+// further backlog) and returns the leftover fraction of a step, which render
+// positions are interpolated by. Otherwise runs one update_game(frame_time)
+// and returns 1.
+float advance_game(float frame_time);
+// World snapshots in the world_file.h format: the entity arrays, the random
+// stream state and the world parameters. write_world_snapshot fills out with
+// get_world_snapshot_size() bytes and returns 0 if size is too small.
+int get_world_snapshot_size();
+int write_world_snapshot(void* out, int size);
+// Replaces the world with a snapshot held in memory and simulates directly on
+// its arrays, without parsing or copying. data must be 64-byte aligned and stay
+// alive and writable until the next init_game or load. alloc_world_buffer
+// returns such memory, owned by the game, for the page to copy a fetched
+// ArrayBuffer into; it drops the current world. Both return 0/null on failure,
+// which includes snapshots whose id tables disagree or whose teams are not 0-3.
+void* alloc_world_buffer(int size);
+int load_world_from_memory(void* data, int size);
+#ifndef __EMSCRIPTEN__
+int save_world(const char* path);
+// Memory-maps the file copy-on-write and runs on the mapping
+int load_world(const char* path);
+#endif
+
+// Replay recording (replay.h). From the next step on, every step's direction
+// changes are appended to the stream, with a full keyframe every
+// keyframe_interval steps and after any spawn, despawn or world load. The
+// stream stays readable after stopping, until the next start.
+void start_replay_recording(int keyframe_interval);
+void stop_replay_recording();
+const uint8_t* get_replay_data();
+int get_replay_size();
+
+// ticks_per_second <= 0 switches back to one variable step per frame
+void set_fixed_timestep(float ticks_per_second, int max_steps_per_frame);
+float get_interpolation_alpha();
+// Steps taken since init_game
+uint32_t get_game_tick();
+
+// Per-frame entry point for the render loop. Synchronously this is
+// advance_game(frame_time). With async simulation on, it instead publishes the
+// step started last frame to the renderer and starts the next one on the
+// worker thread, so simulation and rendering overlap and what is drawn is one
+// frame behind. cull_ai_view, get_sim_snapshot, get_camera_x/y and
+// get_interpolation_alpha then read the published state; every other call
+// waits for the running step first.
+void begin_game_step(float frame_time);
+// Waits for the step begun by begin_game_step, if still running
+void finish_game_step();
+// Ignored (stays synchronous) in builds without thread support
+void set_async_simulation(int enabled);
+int get_async_simulation();
+// Seed for the per-entity random streams, applied from the next update
+void set_game_seed(int seed);
+// Threads used by update_game, including the calling thread
+void set_worker_count(int num_workers);
+
+// Index of the new entity, or -1 when the store is full or the team is
+// outside 0-3
+int spawn_ai(float x, float y, int team);
+int despawn_ai(int ai_index);
+int get_ai_count();
+int get_ai_index(int ai_id);
+int get_ai_id(int ai_index);
+
+const struct SimSnapshot* get_sim_snapshot();
+
+// Neighbour and range queries over the uniform spatial grid, which is rebuilt
+// by update_game. Write up to max_out dense entity indices whose position lies
+// inside the circle or box and return how many were written.
+void set_spatial_cell_size(float cell_size); // applied by the next init_game
+void set_world_bounds(float world_bounds);   // applied by the next init_game
+int query_ai_radius(float x, float y, float radius, int* out_indices, int max_out);
+int query_ai_aabb(float min_x, float min_y, float max_x, float max_y, int* out_indices, int max_out);
+
+// Agent-agent collisions (collision.h): after moving, overlapping 20x20
+// squares are pushed apart. Off by default; the browser demo turns them on
+// with ?collisions=1.
+void set_collisions(int enabled);
+int get_collisions();
+// Overlapping pairs found by the last step, before they were pushed apart
+int get_collision_contacts();
+
+// Team steering (steering.h): separation from, alignment with and cohesion
+// towards teammates and avoidance of other teams, from a fixed budget of
+// neighbours per entity. Applies from the next step.
+void set_ai_behaviour(int behaviour);
+int get_ai_behaviour();
+void set_steering_weights(float separation, float alignment, float cohesion, float avoidance);
+
+// Goal seeking (flow_field.h): entities of a team with goals turn along a
+// per-team flow field towards the cheapest goal, around blocked cells. The
+// grid covers the world bounds; goals and costs are cleared by init_game and
+// world loads and take effect from the next step. Costs are 1-254 per cell,
+// 255 blocks it. add_team_goal returns 0 for a team outside 0-3.
+void set_flow_cell_size(float cell_size); // applied by the next init_game
+int add_team_goal(int team, float x, float y);
+void clear_team_goals(int team);
+void set_flow_cost(float min_x, float min_y, float max_x, float max_y, int cost);
+
+// Simulation level of detail (lod.h): entities are tiered by distance to the
+// nearest camera-followed entity (ids 0-3). Tier 0 (within near_radius) is
+// stepped every tick; tier 1 (within far_radius) every mid_interval ticks and
+// tier 2 every far_interval ticks, as plain random walkers (goal seeking
+// included, no flocking or collision pushes) that catch up on skipped ticks in
+// closed form. Between their steps, far entities' positions lag by up to one
+// interval. Assumes a fixed step length; suspended while a replay records.
+// Tiers only run with collisions or AI_BEHAVIOUR_FLOCK on; a plain random walk
+// is cheaper to step in full. Intervals are rounded up to powers of two. Off
+// by default; defaults 800 px, 1600 px, 4 and 16 ticks.
+void set_simulation_lod(int enabled);
+int get_simulation_lod();
+void set_lod_tiers(float near_radius, float far_radius, int mid_interval, int far_interval);
+// Entities in a tier after the last step
+int get_lod_tier_count(int tier);
+
+// Split the entities into those visible in the view rectangle centred on
+// (center_x, center_y) and those outside it, for one of the NUM_AI_ENTITIES
+// viewports, using the interpolated render positions. The result stays valid
+// until the next call for that viewport.
+const struct ViewCull* cull_ai_view(int viewport_index, float center_x, float center_y,
+                                    float half_width, float half_height);
+
+// Render-time centre of a viewport's camera: the entity with id viewport_index
+float get_camera_x(int viewport_index);
+float get_camera_y(int viewport_index);
+
 float get_ai_x(int ai_index);
 float get_ai_y(int ai_index);
 int get_ai_team(int ai_index);
+// Position interpolated between the last two steps by the current alpha, for
+// cameras and anything else drawn alongside the culled views
+float get_ai_render_x(int ai_index);
+float get_ai_render_y(int ai_index);
 
 #ifdef __cplusplus
 }
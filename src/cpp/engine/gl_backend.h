@@ -0,0 +1,56 @@
+#ifndef GL_BACKEND_H
+#define GL_BACKEND_H
+
+// GL entry points for the renderer. The browser build calls WebGL 2 through
+// Emscripten's GLES3 bindings; native builds (or any build defining
+// GL_BACKEND_STUB) get the recording stub from gl_stub.cpp instead, so the
+// renderer can run and be measured without a GPU.
+#if defined(__EMSCRIPTEN__) && !defined(GL_BACKEND_STUB)
+#include <GLES3/gl3.h>
+#else
+#ifndef GL_BACKEND_STUB
+#define GL_BACKEND_STUB
+#endif
+#include "gl_stub.h"
+#endif
+
+#include "profiler.h"
+
+#ifdef ENABLE_PROFILER
+// Count every GL call for the profiler. A macro is not expanded again inside
+// its own replacement, so each one still ends up calling the real function.
+// (gl_stub.cpp defines these functions, so it includes gl_stub.h directly.)
+#define glAttachShader(...) (PROFILE_GL_CALLS(1), glAttachShader(__VA_ARGS__))
+#define glBindBuffer(...) (PROFILE_GL_CALLS(1), glBindBuffer(__VA_ARGS__))
+#define glBindVertexArray(...) (PROFILE_GL_CALLS(1), glBindVertexArray(__VA_ARGS__))
+#define glBufferData(...) (PROFILE_GL_CALLS(1), glBufferData(__VA_ARGS__))
+#define glBufferSubData(...) (PROFILE_GL_CALLS(1), glBufferSubData(__VA_ARGS__))
+#define glClear(...) (PROFILE_GL_CALLS(1), glClear(__VA_ARGS__))
+#define glClearColor(...) (PROFILE_GL_CALLS(1), glClearColor(__VA_ARGS__))
+#define glCompileShader(...) (PROFILE_GL_CALLS(1), glCompileShader(__VA_ARGS__))
+#define glCreateProgram(...) (PROFILE_GL_CALLS(1), glCreateProgram(__VA_ARGS__))
+#define glCreateShader(...) (PROFILE_GL_CALLS(1), glCreateShader(__VA_ARGS__))
+#define glDeleteShader(...) (PROFILE_GL_CALLS(1), glDeleteShader(__VA_ARGS__))
+#define glDisable(...) (PROFILE_GL_CALLS(1), glDisable(__VA_ARGS__))
+#define glEnable(...) (PROFILE_GL_CALLS(1), glEnable(__VA_ARGS__))
+#define glEnableVertexAttribArray(...) (PROFILE_GL_CALLS(1), glEnableVertexAttribArray(__VA_ARGS__))
+#define glGenBuffers(...) (PROFILE_GL_CALLS(1), glGenBuffers(__VA_ARGS__))
+#define glGenVertexArrays(...) (PROFILE_GL_CALLS(1), glGenVertexArrays(__VA_ARGS__))
+#define glGetProgramiv(...) (PROFILE_GL_CALLS(1), glGetProgramiv(__VA_ARGS__))
+#define glGetShaderiv(...) (PROFILE_GL_CALLS(1), glGetShaderiv(__VA_ARGS__))
+#define glGetUniformLocation(...) (PROFILE_GL_CALLS(1), glGetUniformLocation(__VA_ARGS__))
+#define glLinkProgram(...) (PROFILE_GL_CALLS(1), glLinkProgram(__VA_ARGS__))
+#define glScissor(...) (PROFILE_GL_CALLS(1), glScissor(__VA_ARGS__))
+#define glShaderSource(...) (PROFILE_GL_CALLS(1), glShaderSource(__VA_ARGS__))
+#define glUniform1f(...) (PROFILE_GL_CALLS(1), glUniform1f(__VA_ARGS__))
+#define glUniform2f(...) (PROFILE_GL_CALLS(1), glUniform2f(__VA_ARGS__))
+#define glUniform3fv(...) (PROFILE_GL_CALLS(1), glUniform3fv(__VA_ARGS__))
+#define glUseProgram(...) (PROFILE_GL_CALLS(1), glUseProgram(__VA_ARGS__))
+#define glVertexAttribDivisor(...) (PROFILE_GL_CALLS(1), glVertexAttribDivisor(__VA_ARGS__))
+#define glVertexAttribPointer(...) (PROFILE_GL_CALLS(1), glVertexAttribPointer(__VA_ARGS__))
+#define glViewport(...) (PROFILE_GL_CALLS(1), glViewport(__VA_ARGS__))
+#define glDrawArrays(...) (PROFILE_GL_CALLS(1), PROFILE_DRAW_CALLS(1), glDrawArrays(__VA_ARGS__))
+#define glDrawArraysInstanced(...) (PROFILE_GL_CALLS(1), PROFILE_DRAW_CALLS(1), glDrawArraysInstanced(__VA_ARGS__))
+#endif
+
+#endif
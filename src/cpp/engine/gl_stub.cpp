@@ -0,0 +1,243 @@
+#include "gl_stub.h"
+#include <cstring>
+#include <string>
+#include <vector>
+
+static GlStubStats g_stats;
+static bool g_recording = false;
+static std::vector<GlStubCommand> g_commands;
+
+static GLuint g_next_name = 1; // shared by every object type, 0 is never handed out
+static GLuint g_current_program = 0;
+static GLuint g_current_vertex_array = 0;
+static std::vector<std::string> g_uniform_names; // location = index
+
+static const char* g_op_names[GL_STUB_OP_COUNT] = {
+    "glAttachShader", "glBindBuffer", "glBindVertexArray", "glBufferData", "glBufferSubData",
+    "glClear", "glClearColor", "glCompileShader", "glCreateProgram", "glCreateShader",
+    "glDeleteShader", "glDisable", "glDrawArrays", "glDrawArraysInstanced", "glEnable",
+    "glEnableVertexAttribArray", "glGenBuffers", "glGenVertexArrays", "glGetProgramiv", "glGetShaderiv",
+    "glGetUniformLocation", "glLinkProgram", "glScissor", "glShaderSource", "glUniform",
+    "glUseProgram", "glVertexAttribDivisor", "glVertexAttribPointer", "glViewport"
+};
+
+static void record(GlStubOp op, int64_t a0 = 0, int64_t a1 = 0, int64_t a2 = 0, int64_t a3 = 0) {
+    g_stats.calls++;
+    if (!g_recording) return;
+
+    GlStubCommand command;
+    command.op = op;
+    command.args[0] = a0;
+    command.args[1] = a1;
+    command.args[2] = a2;
+    command.args[3] = a3;
+    command.program = g_current_program;
+    command.vertex_array = g_current_vertex_array;
+    g_commands.push_back(command);
+}
+
+static void count_draw(GLsizei vertices, GLsizei instances) {
+    g_stats.draw_calls++;
+    g_stats.instances_drawn += instances;
+    g_stats.vertices_drawn += (long long)vertices * instances;
+}
+
+extern "C" {
+    void glAttachShader(GLuint program, GLuint shader) {
+        record(GL_STUB_ATTACH_SHADER, program, shader);
+    }
+
+    void glBindBuffer(GLenum target, GLuint buffer) {
+        record(GL_STUB_BIND_BUFFER, target, buffer);
+        g_stats.state_changes++;
+    }
+
+    void glBindVertexArray(GLuint array) {
+        record(GL_STUB_BIND_VERTEX_ARRAY, array);
+        g_stats.state_changes++;
+        g_current_vertex_array = array;
+    }
+
+    void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage) {
+        record(GL_STUB_BUFFER_DATA, target, size, data != nullptr, usage);
+        g_stats.buffer_allocations++;
+        if (data) {
+            g_stats.buffer_uploads++;
+            g_stats.upload_bytes += size;
+        }
+    }
+
+    void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data) {
+        record(GL_STUB_BUFFER_SUB_DATA, target, offset, size);
+        (void)data;
+        g_stats.buffer_uploads++;
+        g_stats.upload_bytes += size;
+    }
+
+    void glClear(GLbitfield mask) {
+        record(GL_STUB_CLEAR, mask);
+        g_stats.clears++;
+    }
+
+    void glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha) {
+        record(GL_STUB_CLEAR_COLOR);
+        (void)red; (void)green; (void)blue; (void)alpha;
+        g_stats.state_changes++;
+    }
+
+    void glCompileShader(GLuint shader) {
+        record(GL_STUB_COMPILE_SHADER, shader);
+    }
+
+    GLuint glCreateProgram(void) {
+        GLuint name = g_next_name++;
+        record(GL_STUB_CREATE_PROGRAM, name);
+        g_stats.programs_created++;
+        return name;
+    }
+
+    GLuint glCreateShader(GLenum type) {
+        GLuint name = g_next_name++;
+        record(GL_STUB_CREATE_SHADER, type, name);
+        g_stats.shaders_created++;
+        return name;
+    }
+
+    void glDeleteShader(GLuint shader) {
+        record(GL_STUB_DELETE_SHADER, shader);
+    }
+
+    void glDisable(GLenum cap) {
+        record(GL_STUB_DISABLE, cap);
+        g_stats.state_changes++;
+    }
+
+    void glDrawArrays(GLenum mode, GLint first, GLsizei count) {
+        record(GL_STUB_DRAW_ARRAYS, mode, first, count);
+        count_draw(count, 1);
+    }
+
+    void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instance_count) {
+        record(GL_STUB_DRAW_ARRAYS_INSTANCED, mode, first, count, instance_count);
+        count_draw(count, instance_count);
+    }
+
+    void glEnable(GLenum cap) {
+        record(GL_STUB_ENABLE, cap);
+        g_stats.state_changes++;
+    }
+
+    void glEnableVertexAttribArray(GLuint index) {
+        record(GL_STUB_ENABLE_VERTEX_ATTRIB_ARRAY, index);
+        g_stats.state_changes++;
+    }
+
+    void glGenBuffers(GLsizei n, GLuint* buffers) {
+        for (GLsizei i = 0; i < n; i++) buffers[i] = g_next_name++;
+        record(GL_STUB_GEN_BUFFERS, n, n > 0 ? buffers[0] : 0);
+        g_stats.buffers_created += n;
+    }
+
+    void glGenVertexArrays(GLsizei n, GLuint* arrays) {
+        for (GLsizei i = 0; i < n; i++) arrays[i] = g_next_name++;
+        record(GL_STUB_GEN_VERTEX_ARRAYS, n, n > 0 ? arrays[0] : 0);
+        g_stats.vertex_arrays_created += n;
+    }
+
+    void glGetProgramiv(GLuint program, GLenum pname, GLint* params) {
+        record(GL_STUB_GET_PROGRAMIV, program, pname);
+        *params = GL_TRUE;
+    }
+
+    void glGetShaderiv(GLuint shader, GLenum pname, GLint* params) {
+        record(GL_STUB_GET_SHADERIV, shader, pname);
+        *params = GL_TRUE;
+    }
+
+    GLint glGetUniformLocation(GLuint program, const GLchar* name) {
+        // One location per distinct name, the same for every program
+        GLint location = 0;
+        while (location < (GLint)g_uniform_names.size() && g_uniform_names[location] != name) location++;
+        if (location == (GLint)g_uniform_names.size()) g_uniform_names.push_back(name);
+
+        record(GL_STUB_GET_UNIFORM_LOCATION, program, location);
+        return location;
+    }
+
+    void glLinkProgram(GLuint program) {
+        record(GL_STUB_LINK_PROGRAM, program);
+    }
+
+    void glScissor(GLint x, GLint y, GLsizei width, GLsizei height) {
+        record(GL_STUB_SCISSOR, x, y, width, height);
+        g_stats.state_changes++;
+    }
+
+    void glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length) {
+        record(GL_STUB_SHADER_SOURCE, shader, count);
+        (void)string; (void)length;
+    }
+
+    void glUniform1f(GLint location, GLfloat v0) {
+        record(GL_STUB_UNIFORM, location, 1);
+        (void)v0;
+        g_stats.uniform_updates++;
+    }
+
+    void glUniform2f(GLint location, GLfloat v0, GLfloat v1) {
+        record(GL_STUB_UNIFORM, location, 2);
+        (void)v0; (void)v1;
+        g_stats.uniform_updates++;
+    }
+
+    void glUniform3fv(GLint location, GLsizei count, const GLfloat* value) {
+        record(GL_STUB_UNIFORM, location, 3 * count);
+        (void)value;
+        g_stats.uniform_updates++;
+    }
+
+    void glUseProgram(GLuint program) {
+        record(GL_STUB_USE_PROGRAM, program);
+        g_stats.state_changes++;
+        g_current_program = program;
+    }
+
+    void glVertexAttribDivisor(GLuint index, GLuint divisor) {
+        record(GL_STUB_VERTEX_ATTRIB_DIVISOR, index, divisor);
+        g_stats.state_changes++;
+    }
+
+    void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                               const void* pointer) {
+        record(GL_STUB_VERTEX_ATTRIB_POINTER, index, size, type, (int64_t)(intptr_t)pointer);
+        (void)normalized; (void)stride;
+        g_stats.state_changes++;
+    }
+
+    void glViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+        record(GL_STUB_VIEWPORT, x, y, width, height);
+        g_stats.state_changes++;
+    }
+}
+
+void gl_stub_reset() {
+    memset(&g_stats, 0, sizeof(g_stats));
+    g_commands.clear();
+}
+
+void gl_stub_set_recording(bool enabled) {
+    g_recording = enabled;
+}
+
+const GlStubStats& gl_stub_stats() {
+    return g_stats;
+}
+
+const GlStubCommand* gl_stub_commands(int* count) {
+    *count = (int)g_commands.size();
+    return g_commands.data();
+}
+
+const char* gl_stub_op_name(GlStubOp op) {
+    return op >= 0 && op < GL_STUB_OP_COUNT ? g_op_names[op] : "unknown";
+}
@@ -0,0 +1,151 @@
+#ifndef GL_STUB_H
+#define GL_STUB_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Recording stand-in for the subset of OpenGL ES 3.0 the renderer uses, for
+// native builds without a GPU. Every call is counted, object names are handed
+// out like a real driver would, and calls can optionally be captured as a
+// command stream. Shaders always compile and link; nothing is rasterized.
+
+typedef unsigned int GLenum;
+typedef unsigned int GLuint;
+typedef int GLint;
+typedef int GLsizei;
+typedef unsigned int GLbitfield;
+typedef unsigned char GLboolean;
+typedef float GLfloat;
+typedef char GLchar;
+typedef intptr_t GLintptr;
+typedef intptr_t GLsizeiptr;
+
+#define GL_FALSE 0
+#define GL_TRUE 1
+#define GL_LINES 0x0001
+#define GL_TRIANGLES 0x0004
+#define GL_TRIANGLE_FAN 0x0006
+#define GL_COLOR_BUFFER_BIT 0x00004000
+#define GL_SCISSOR_TEST 0x0C11
+#define GL_INT 0x1404
+#define GL_FLOAT 0x1406
+#define GL_ARRAY_BUFFER 0x8892
+#define GL_STREAM_DRAW 0x88E0
+#define GL_STATIC_DRAW 0x88E4
+#define GL_FRAGMENT_SHADER 0x8B30
+#define GL_VERTEX_SHADER 0x8B31
+#define GL_COMPILE_STATUS 0x8B81
+#define GL_LINK_STATUS 0x8B82
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void glAttachShader(GLuint program, GLuint shader);
+void glBindBuffer(GLenum target, GLuint buffer);
+void glBindVertexArray(GLuint array);
+void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+void glClear(GLbitfield mask);
+void glClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+void glCompileShader(GLuint shader);
+GLuint glCreateProgram(void);
+GLuint glCreateShader(GLenum type);
+void glDeleteShader(GLuint shader);
+void glDisable(GLenum cap);
+void glDrawArrays(GLenum mode, GLint first, GLsizei count);
+void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instance_count);
+void glEnable(GLenum cap);
+void glEnableVertexAttribArray(GLuint index);
+void glGenBuffers(GLsizei n, GLuint* buffers);
+void glGenVertexArrays(GLsizei n, GLuint* arrays);
+void glGetProgramiv(GLuint program, GLenum pname, GLint* params);
+void glGetShaderiv(GLuint shader, GLenum pname, GLint* params);
+GLint glGetUniformLocation(GLuint program, const GLchar* name);
+void glLinkProgram(GLuint program);
+void glScissor(GLint x, GLint y, GLsizei width, GLsizei height);
+void glShaderSource(GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length);
+void glUniform1f(GLint location, GLfloat v0);
+void glUniform2f(GLint location, GLfloat v0, GLfloat v1);
+void glUniform3fv(GLint location, GLsizei count, const GLfloat* value);
+void glUseProgram(GLuint program);
+void glVertexAttribDivisor(GLuint index, GLuint divisor);
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized, GLsizei stride,
+                           const void* pointer);
+void glViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+#ifdef __cplusplus
+}
+#endif
+
+// Inspection API
+
+enum GlStubOp {
+    GL_STUB_ATTACH_SHADER,
+    GL_STUB_BIND_BUFFER,
+    GL_STUB_BIND_VERTEX_ARRAY,
+    GL_STUB_BUFFER_DATA,
+    GL_STUB_BUFFER_SUB_DATA,
+    GL_STUB_CLEAR,
+    GL_STUB_CLEAR_COLOR,
+    GL_STUB_COMPILE_SHADER,
+    GL_STUB_CREATE_PROGRAM,
+    GL_STUB_CREATE_SHADER,
+    GL_STUB_DELETE_SHADER,
+    GL_STUB_DISABLE,
+    GL_STUB_DRAW_ARRAYS,
+    GL_STUB_DRAW_ARRAYS_INSTANCED,
+    GL_STUB_ENABLE,
+    GL_STUB_ENABLE_VERTEX_ATTRIB_ARRAY,
+    GL_STUB_GEN_BUFFERS,
+    GL_STUB_GEN_VERTEX_ARRAYS,
+    GL_STUB_GET_PROGRAMIV,
+    GL_STUB_GET_SHADERIV,
+    GL_STUB_GET_UNIFORM_LOCATION,
+    GL_STUB_LINK_PROGRAM,
+    GL_STUB_SCISSOR,
+    GL_STUB_SHADER_SOURCE,
+    GL_STUB_UNIFORM,
+    GL_STUB_USE_PROGRAM,
+    GL_STUB_VERTEX_ATTRIB_DIVISOR,
+    GL_STUB_VERTEX_ATTRIB_POINTER,
+    GL_STUB_VIEWPORT,
+    GL_STUB_OP_COUNT
+};
+
+// One captured call. args holds the call's integer arguments (targets, names,
+// offsets, sizes, counts) in declaration order; floats are not captured.
+// Draws also record the program and vertex array bound at the time.
+struct GlStubCommand {
+    GlStubOp op;
+    int64_t args[4];
+    GLuint program;
+    GLuint vertex_array;
+};
+
+struct GlStubStats {
+    long long calls;                 // every entry point
+    long long buffers_created;       // names from glGenBuffers
+    long long vertex_arrays_created; // names from glGenVertexArrays
+    long long programs_created;
+    long long shaders_created;
+    long long buffer_allocations;    // glBufferData, including orphaning
+    long long buffer_uploads;        // glBufferData with data plus glBufferSubData
+    long long upload_bytes;
+    long long state_changes;         // binds, program switches, enable/disable, viewport, scissor, attribute setup
+    long long uniform_updates;
+    long long clears;
+    long long draw_calls;
+    long long instances_drawn;       // 1 per non-instanced draw
+    long long vertices_drawn;        // vertices x instances
+};
+
+// Clears the counters and captured commands; objects stay alive
+void gl_stub_reset();
+// Capture calls into the command stream (off by default so benchmarks stay cheap)
+void gl_stub_set_recording(bool enabled);
+const GlStubStats& gl_stub_stats();
+const GlStubCommand* gl_stub_commands(int* count);
+const char* gl_stub_op_name(GlStubOp op);
+
+#endif
@@ -0,0 +1,133 @@
+#include "indicators.h"
+#include "simd.h"
+#include <cmath>
+
+// Project SIMD_WIDTH entities onto the view border. The ray from the centre
+// leaves the rectangle through a side edge when it reaches |dx| = half_width
+// before |dy| = half_height, so the exit distance is the smaller of the two
+// ratios and no angle is ever needed.
+static inline void project_lanes(const float* x, const float* y, simd_f32 center_x, simd_f32 center_y,
+                                 simd_f32 half_width, simd_f32 half_height, float* edge_x, float* edge_y,
+                                 float* perimeter) {
+    simd_f32 zero = simd_splat(0.0f);
+    simd_f32 tiny = simd_splat(1e-6f);
+
+    simd_f32 dx = simd_sub(simd_load(x), center_x);
+    simd_f32 dy = simd_sub(simd_load(y), center_y);
+    simd_f32 abs_dx = simd_max(dx, simd_sub(zero, dx));
+    simd_f32 abs_dy = simd_max(dy, simd_sub(zero, dy));
+
+    simd_f32 t_x = simd_div(half_width, simd_max(abs_dx, tiny));
+    simd_f32 t_y = simd_div(half_height, simd_max(abs_dy, tiny));
+    simd_f32 side = simd_cmplt(t_x, t_y); // leaves through the left or right edge
+    simd_f32 t = simd_min(t_x, t_y);
+    simd_f32 ex = simd_mul(dx, t);
+    simd_f32 ey = simd_mul(dy, t);
+
+    // Distance along the border, clockwise from the top-left corner (y grows
+    // downwards): top, right, bottom, then left edge
+    simd_f32 w = simd_add(half_width, half_width);
+    simd_f32 h = simd_add(half_height, half_height);
+    simd_f32 s_top = simd_add(ex, half_width);
+    simd_f32 s_right = simd_add(simd_add(w, half_height), ey);
+    simd_f32 s_bottom = simd_sub(simd_add(simd_add(w, h), half_width), ex);
+    simd_f32 s_left = simd_sub(simd_add(simd_add(simd_add(w, w), h), half_height), ey);
+
+    simd_f32 s = simd_select(side, simd_select(simd_cmpgt(dx, zero), s_right, s_left),
+                             simd_select(simd_cmpgt(dy, zero), s_bottom, s_top));
+
+    simd_store(edge_x, ex);
+    simd_store(edge_y, ey);
+    simd_store(perimeter, s);
+}
+
+int build_indicator_clusters(IndicatorBuffers& buffers, const float* x, const float* y, const int32_t* team,
+                             int count, float center_x, float center_y, float half_width, float half_height,
+                             float segment_length) {
+    buffers.clusters.clear();
+    if (count <= 0) return 0;
+
+    if (buffers.edge_x.size() < (size_t)count) {
+        buffers.edge_x.resize(count);
+        buffers.edge_y.resize(count);
+        buffers.perimeter.resize(count);
+    }
+    float* edge_x = buffers.edge_x.data();
+    float* edge_y = buffers.edge_y.data();
+    float* perimeter = buffers.perimeter.data();
+
+    // Pass 1: border projection for every entity, several at a time
+    simd_f32 cx = simd_splat(center_x), cy = simd_splat(center_y);
+    simd_f32 hw = simd_splat(half_width), hh = simd_splat(half_height);
+    int i = 0;
+    for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+        project_lanes(x + i, y + i, cx, cy, hw, hh, edge_x + i, edge_y + i, perimeter + i);
+    }
+
+    // Tail entities run through the same lanes from a padded copy
+    if (i < count) {
+        float tail_x[SIMD_WIDTH], tail_y[SIMD_WIDTH];
+        float tail_edge_x[SIMD_WIDTH], tail_edge_y[SIMD_WIDTH], tail_perimeter[SIMD_WIDTH];
+        for (int k = 0; k < SIMD_WIDTH; k++) {
+            tail_x[k] = i + k < count ? x[i + k] : center_x + half_width;
+            tail_y[k] = i + k < count ? y[i + k] : center_y;
+        }
+        project_lanes(tail_x, tail_y, cx, cy, hw, hh, tail_edge_x, tail_edge_y, tail_perimeter);
+        for (int k = 0; i + k < count; k++) {
+            edge_x[i + k] = tail_edge_x[k];
+            edge_y[i + k] = tail_edge_y[k];
+            perimeter[i + k] = tail_perimeter[k];
+        }
+    }
+
+    // Pass 2: accumulate into (team, border segment) buckets
+    float perimeter_length = 4.0f * (half_width + half_height);
+    int num_segments = (int)ceilf(perimeter_length / segment_length);
+    if (num_segments < 1) num_segments = 1;
+    float segments_per_pixel = num_segments / perimeter_length;
+    int num_buckets = INDICATOR_TEAMS * num_segments;
+
+    buffers.sum_dx.assign(num_buckets, 0.0f);
+    buffers.sum_dy.assign(num_buckets, 0.0f);
+    buffers.sum_edge_x.assign(num_buckets, 0.0f);
+    buffers.sum_edge_y.assign(num_buckets, 0.0f);
+    buffers.bucket_count.assign(num_buckets, 0);
+    float* sum_dx = buffers.sum_dx.data();
+    float* sum_dy = buffers.sum_dy.data();
+    float* sum_edge_x = buffers.sum_edge_x.data();
+    float* sum_edge_y = buffers.sum_edge_y.data();
+    int32_t* bucket_count = buffers.bucket_count.data();
+
+    for (int k = 0; k < count; k++) {
+        int segment = (int)(perimeter[k] * segments_per_pixel);
+        segment = segment < 0 ? 0 : (segment >= num_segments ? num_segments - 1 : segment);
+        int team_slot = team[k] >= 0 && team[k] < INDICATOR_TEAMS - 1 ? team[k] : INDICATOR_TEAMS - 1;
+        int bucket = team_slot * num_segments + segment;
+
+        sum_dx[bucket] += x[k] - center_x;
+        sum_dy[bucket] += y[k] - center_y;
+        sum_edge_x[bucket] += edge_x[k];
+        sum_edge_y[bucket] += edge_y[k];
+        bucket_count[bucket]++;
+    }
+
+    // One arrow per occupied bucket, pointing at the group's mean offset
+    for (int bucket = 0; bucket < num_buckets; bucket++) {
+        int n = bucket_count[bucket];
+        if (n == 0) continue;
+
+        float inv_n = 1.0f / n;
+        float length = sqrtf(sum_dx[bucket] * sum_dx[bucket] + sum_dy[bucket] * sum_dy[bucket]);
+        float inv_length = length > 0.0f ? 1.0f / length : 0.0f;
+
+        IndicatorCluster cluster;
+        cluster.x = center_x + sum_edge_x[bucket] * inv_n;
+        cluster.y = center_y + sum_edge_y[bucket] * inv_n;
+        cluster.dir_x = sum_dx[bucket] * inv_length;
+        cluster.dir_y = sum_dy[bucket] * inv_length;
+        cluster.team = bucket / num_segments;
+        cluster.count = n;
+        buffers.clusters.push_back(cluster);
+    }
+    return (int)buffers.clusters.size();
+}
@@ -0,0 +1,40 @@
+#ifndef INDICATORS_H
+#define INDICATORS_H
+
+#include <cstdint>
+#include <vector>
+
+// Edge indicators for off-screen entities. Each entity is projected onto the
+// border of the view rectangle along the ray from the camera centre, and
+// entities of the same team landing on the same stretch of border are merged
+// into one arrow, so the arrow count is bounded by teams x border segments
+// however many entities are off screen.
+
+// Teams 0-3 plus one bucket for out-of-range team values
+#define INDICATOR_TEAMS 5
+
+// One aggregated arrow
+struct IndicatorCluster {
+    float x, y;         // mean border point in world coordinates
+    float dir_x, dir_y; // unit direction from the camera towards the group
+    int32_t team;
+    int32_t count;      // entities represented
+};
+
+// Scratch and output storage, reused from frame to frame
+struct IndicatorBuffers {
+    std::vector<float> edge_x, edge_y;  // border point relative to the centre
+    std::vector<float> perimeter;       // distance along the border, clockwise from top-left
+    std::vector<float> sum_dx, sum_dy, sum_edge_x, sum_edge_y; // per bucket
+    std::vector<int32_t> bucket_count;
+    std::vector<IndicatorCluster> clusters;
+};
+
+// Builds buffers.clusters from count off-screen entities, splitting the
+// border of the view centred on (center_x, center_y) into segments of about
+// segment_length pixels. Returns the number of clusters.
+int build_indicator_clusters(IndicatorBuffers& buffers, const float* x, const float* y, const int32_t* team,
+                             int count, float center_x, float center_y, float half_width, float half_height,
+                             float segment_length);
+
+#endif
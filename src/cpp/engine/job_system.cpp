@@ -0,0 +1,178 @@
+#include "job_system.h"
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define JOB_SYSTEM_THREADS 0
+#else
+#define JOB_SYSTEM_THREADS 1
+#endif
+
+#if JOB_SYSTEM_THREADS
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define MAX_JOB_WORKERS 64
+
+struct Job {
+    JobRangeFn fn;
+    int begin, end;
+    void* user_data;
+    std::atomic<int>* remaining; // chunks left in the owning parallel_for
+};
+
+struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<Job> jobs;
+};
+
+static WorkerQueue g_queues[MAX_JOB_WORKERS];
+static std::vector<std::thread> g_threads;
+static int g_num_workers = 1;
+
+static std::atomic<int> g_queued_jobs(0);
+static std::atomic<bool> g_running(false);
+static std::mutex g_wake_mutex;
+static std::condition_variable g_wake;
+
+// Owner end: newest job first keeps the worker on memory it just touched
+static bool pop_local(int worker, Job& job) {
+    WorkerQueue& queue = g_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.jobs.empty()) return false;
+    job = queue.jobs.back();
+    queue.jobs.pop_back();
+    return true;
+}
+
+// Thief end: oldest job from the first non-empty victim after this worker
+static bool steal(int worker, Job& job) {
+    for (int offset = 1; offset < g_num_workers; offset++) {
+        WorkerQueue& queue = g_queues[(worker + offset) % g_num_workers];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.jobs.empty()) continue;
+        job = queue.jobs.front();
+        queue.jobs.pop_front();
+        return true;
+    }
+    return false;
+}
+
+static bool try_run_one(int worker) {
+    Job job;
+    if (!pop_local(worker, job) && !steal(worker, job)) return false;
+
+    g_queued_jobs.fetch_sub(1, std::memory_order_relaxed);
+    job.fn(job.begin, job.end, job.user_data);
+    job.remaining->fetch_sub(1, std::memory_order_release);
+    return true;
+}
+
+static void worker_main(int worker) {
+    while (g_running.load(std::memory_order_acquire)) {
+        if (try_run_one(worker)) continue;
+
+        std::unique_lock<std::mutex> lock(g_wake_mutex);
+        g_wake.wait(lock, [] {
+            return g_queued_jobs.load(std::memory_order_relaxed) > 0 || !g_running.load(std::memory_order_relaxed);
+        });
+    }
+}
+
+void job_system_init(int num_workers) {
+    if (num_workers < 1) num_workers = 1;
+    if (num_workers > MAX_JOB_WORKERS) num_workers = MAX_JOB_WORKERS;
+    if (num_workers == g_num_workers) return;
+
+    job_system_shutdown();
+
+    g_num_workers = num_workers;
+    if (num_workers == 1) return;
+
+    g_running = true;
+    for (int worker = 1; worker < num_workers; worker++) {
+        g_threads.emplace_back(worker_main, worker);
+    }
+}
+
+void job_system_shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(g_wake_mutex);
+        g_running = false;
+    }
+    g_wake.notify_all();
+
+    for (std::thread& thread : g_threads) {
+        thread.join();
+    }
+    g_threads.clear();
+    g_num_workers = 1;
+}
+
+int job_system_worker_count() {
+    return g_num_workers;
+}
+
+void job_system_parallel_for(int count, int chunk_size, JobRangeFn fn, void* user_data) {
+    if (count <= 0) return;
+    if (chunk_size < 1) chunk_size = 1;
+
+    // Not worth waking anyone for a single chunk
+    if (g_num_workers == 1 || count <= chunk_size) {
+        fn(0, count, user_data);
+        return;
+    }
+
+    int num_chunks = (count + chunk_size - 1) / chunk_size;
+    std::atomic<int> remaining(num_chunks);
+    {
+        std::lock_guard<std::mutex> lock(g_wake_mutex);
+        g_queued_jobs.fetch_add(num_chunks, std::memory_order_relaxed);
+    }
+
+    // Deal chunks round-robin so every worker starts with local work
+    for (int chunk = 0; chunk < num_chunks; chunk++) {
+        Job job;
+        job.fn = fn;
+        job.begin = chunk * chunk_size;
+        job.end = job.begin + chunk_size < count ? job.begin + chunk_size : count;
+        job.user_data = user_data;
+        job.remaining = &remaining;
+
+        WorkerQueue& queue = g_queues[chunk % g_num_workers];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.jobs.push_back(job);
+    }
+    g_wake.notify_all();
+
+    // Help out until the last chunk has finished
+    while (remaining.load(std::memory_order_acquire) > 0) {
+        if (!try_run_one(0)) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+#else
+
+void job_system_init(int num_workers) {
+    (void)num_workers;
+}
+
+void job_system_shutdown() {
+}
+
+int job_system_worker_count() {
+    return 1;
+}
+
+void job_system_parallel_for(int count, int chunk_size, JobRangeFn fn, void* user_data) {
+    (void)chunk_size;
+    if (count > 0) {
+        fn(0, count, user_data);
+    }
+}
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+// Fork-join job pool with one deque per worker and work stealing.
+// A worker pops jobs from the back of its own deque and, once it runs dry,
+// steals from the front of the others. The thread calling
+// job_system_parallel_for acts as worker 0 and helps until every chunk is
+// done, so the call is also the join point.
+//
+// Builds without thread support (plain emcc, no -pthread) run every job
+// inline on the calling thread.
+
+typedef void (*JobRangeFn)(int begin, int end, void* user_data);
+
+// Starts num_workers - 1 background threads (the caller is the remaining
+// worker). Re-initializing with a different count restarts the pool.
+void job_system_init(int num_workers);
+void job_system_shutdown();
+int job_system_worker_count();
+
+// Splits [0, count) into chunk_size ranges, runs fn on each across the pool
+// and returns once all of them have finished. Only one thread may be inside
+// parallel_for at a time.
+void job_system_parallel_for(int count, int chunk_size, JobRangeFn fn, void* user_data);
+
+#endif
@@ -0,0 +1,66 @@
+#include "lod.h"
+#include <cmath>
+
+LodParams lod_default_params() {
+    LodParams params;
+    params.radius[0] = 800.0f;
+    params.radius[1] = 1600.0f;
+    params.interval[0] = 1;
+    params.interval[1] = 4;
+    params.interval[2] = 16;
+    return params;
+}
+
+uint32_t lod_interval(int ticks) {
+    uint32_t interval = 1;
+    while ((int)interval < ticks && interval < (1u << 30)) interval <<= 1;
+    return interval;
+}
+
+uint32_t lod_max_interval(const LodParams& params) {
+    uint32_t largest = 1;
+    for (int t = 0; t < LOD_TIERS; t++) largest = params.interval[t] > largest ? params.interval[t] : largest;
+    return largest;
+}
+
+void lod_schedule(const LodParams& params, uint32_t tick, const uint32_t* id, const uint8_t* tier,
+                  uint32_t* stepped_tick, float* steps, int begin, int end) {
+    uint32_t mask[LOD_TIERS];
+    for (int t = 0; t < LOD_TIERS; t++) mask[t] = params.interval[t] - 1;
+
+    // Straight-line arithmetic, since which entities are due looks random
+    for (int i = begin; i < end; i++) {
+        uint32_t due = ((tick + id[i]) & mask[tier[i]]) == 0;
+        uint32_t taken = (tick + 1 - stepped_tick[i]) * due;
+        steps[i] = (float)(int32_t)taken;
+        stepped_tick[i] += taken;
+    }
+}
+
+void lod_assign_tiers(const LodParams& params, const LodViews& views, const float* x, const float* y,
+                      const float* steps, uint8_t* tier, int begin, int end) {
+    float radius_sq[LOD_TIERS - 1];
+    for (int t = 0; t < LOD_TIERS - 1; t++) radius_sq[t] = params.radius[t] * params.radius[t];
+
+    // Missing views sit at infinity, so every entity pays for all of them
+    // and the loop has no data-dependent branches
+    float view_x[LOD_MAX_VIEWS], view_y[LOD_MAX_VIEWS];
+    for (int v = 0; v < LOD_MAX_VIEWS; v++) {
+        view_x[v] = v < views.count ? views.x[v] : 3.0e18f;
+        view_y[v] = v < views.count ? views.y[v] : 3.0e18f;
+    }
+    if (views.count == 0) radius_sq[0] = INFINITY;
+
+    for (int i = begin; i < end; i++) {
+        float nearest_sq = INFINITY;
+        for (int v = 0; v < LOD_MAX_VIEWS; v++) {
+            float dx = x[i] - view_x[v], dy = y[i] - view_y[v];
+            float dist_sq = dx * dx + dy * dy;
+            nearest_sq = dist_sq < nearest_sq ? dist_sq : nearest_sq;
+        }
+        int t = 0;
+        for (int r = 0; r < LOD_TIERS - 1; r++) t += nearest_sq >= radius_sq[r];
+        int stepped = steps[i] != 0.0f;
+        tier[i] = (uint8_t)(t * stepped + tier[i] * (1 - stepped));
+    }
+}
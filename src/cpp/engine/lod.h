@@ -0,0 +1,53 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include <cstdint>
+
+// Simulation level of detail. Entities are sorted into tiers by distance to
+// the nearest view centre. Tier 0 is stepped every tick with everything on;
+// tier t > 0 is stepped every interval[t] ticks as a plain random walk (goal
+// seeking included), and each step catches up on the ticks it skipped with
+// one closed-form advance (integrate_and_bounce_steps). Straight runs with
+// bounces have an exact solution, so a far entity ends up where stepping it
+// every tick would have put it, up to rounding. Direction changes still
+// happen on their tick: the caller brings the entity up to date first.
+//
+// An entity's phase within its interval comes from its id, so each tick steps
+// an even share of every tier. Tiers are re-evaluated whenever an entity is
+// stepped, so a far entity notices an approaching view within one interval;
+// the radii should leave room for the distance a view covers in that time.
+
+#define LOD_TIERS 3
+#define LOD_MAX_VIEWS 4
+
+struct LodParams {
+    float radius[LOD_TIERS - 1]; // tier t holds distances below radius[t]; the last tier everything beyond
+    uint32_t interval[LOD_TIERS]; // ticks between steps, powers of two, interval[0] = 1
+};
+
+struct LodViews {
+    float x[LOD_MAX_VIEWS];
+    float y[LOD_MAX_VIEWS];
+    int count;
+};
+
+LodParams lod_default_params();
+
+// Rounds an interval up to the power of two lod_schedule needs
+uint32_t lod_interval(int ticks);
+
+// Largest interval, i.e. the most steps one entity can take in a tick
+uint32_t lod_max_interval(const LodParams& params);
+
+// Which of the entities [begin, end) are stepped in step `tick`: steps[i] is
+// how many steps each catches up, tick + 1 - stepped_tick[i], or 0 when not
+// due. Due entities get stepped_tick[i] = tick + 1.
+void lod_schedule(const LodParams& params, uint32_t tick, const uint32_t* id, const uint8_t* tier,
+                  uint32_t* stepped_tick, float* steps, int begin, int end);
+
+// Re-tiers the entities [begin, end) that were stepped (steps[i] > 0) from
+// their new positions. With no views everything is tier 0.
+void lod_assign_tiers(const LodParams& params, const LodViews& views, const float* x, const float* y,
+                      const float* steps, uint8_t* tier, int begin, int end);
+
+#endif
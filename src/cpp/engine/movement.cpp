@@ -0,0 +1,150 @@
+#include "movement.h"
+#include "simd.h"
+#include <cmath>
+
+// Clamp and reflect one axis. Reflection flips the sign bit only in lanes that
+// left the world, which is exact, so it matches the scalar negation.
+static inline void bounce_axis(simd_f32& pos, simd_f32& vel, simd_f32 lo, simd_f32 hi, simd_f32 sign_bit) {
+    simd_f32 outside = simd_or(simd_cmplt(pos, lo), simd_cmpgt(pos, hi));
+    vel = simd_xor(vel, simd_and(outside, sign_bit));
+    pos = simd_max(simd_min(pos, hi), lo);
+}
+
+void integrate_and_bounce(float* x, float* y, float* vx, float* vy, int count,
+                          float delta_time, float bounds) {
+    simd_f32 dt = simd_splat(delta_time);
+    simd_f32 lo = simd_splat(-bounds);
+    simd_f32 hi = simd_splat(bounds);
+    simd_f32 sign_bit = simd_splat(-0.0f);
+
+    int i = 0;
+    for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+        simd_f32 px = simd_load(x + i);
+        simd_f32 py = simd_load(y + i);
+        simd_f32 pvx = simd_load(vx + i);
+        simd_f32 pvy = simd_load(vy + i);
+
+        // Update position
+        px = simd_add(px, simd_mul(pvx, dt));
+        py = simd_add(py, simd_mul(pvy, dt));
+
+        // Keep entities within world bounds (bounce off edges)
+        bounce_axis(px, pvx, lo, hi, sign_bit);
+        bounce_axis(py, pvy, lo, hi, sign_bit);
+
+        simd_store(x + i, px);
+        simd_store(y + i, py);
+        simd_store(vx + i, pvx);
+        simd_store(vy + i, pvy);
+    }
+
+    // Tail entities that do not fill a whole vector
+    if (i < count) {
+        integrate_and_bounce_reference(x + i, y + i, vx + i, vy + i, count - i, delta_time, bounds);
+    }
+}
+
+void integrate_and_bounce_reference(float* x, float* y, float* vx, float* vy, int count,
+                                    float delta_time, float bounds) {
+    for (int i = 0; i < count; i++) {
+        // Update position
+        x[i] += vx[i] * delta_time;
+        y[i] += vy[i] * delta_time;
+
+        // Keep entities within world bounds (bounce off edges)
+        if (x[i] < -bounds || x[i] > bounds) {
+            vx[i] = -vx[i];
+            x[i] = x[i] < -bounds ? -bounds : bounds;
+        }
+        if (y[i] < -bounds || y[i] > bounds) {
+            vy[i] = -vy[i];
+            y[i] = y[i] < -bounds ? -bounds : bounds;
+        }
+    }
+}
+
+// Several steps along one axis. A single step out of the world clamps and
+// reflects like integrate_and_bounce_reference; longer runs hop from wall to
+// wall, each leg ending on the first step that would have left the world.
+static inline void advance_axis(float& pos, float& vel, float steps, float delta_time, float bounds) {
+    float d = vel * delta_time;
+    float p = pos + d * steps;
+    if (p >= -bounds && p <= bounds) {
+        pos = p;
+        return;
+    }
+    if (steps <= 1.0f) {
+        vel = -vel;
+        pos = p < -bounds ? -bounds : bounds;
+        return;
+    }
+
+    float remaining = steps;
+    p = pos;
+    for (;;) {
+        float wall = d > 0.0f ? bounds : -bounds;
+        float leg = floorf((wall - p) / d) + 1.0f;
+        if (leg > remaining) {
+            p += d * remaining;
+            break;
+        }
+        p = wall;
+        vel = -vel;
+        d = -d;
+        remaining -= leg;
+        if (remaining <= 0.0f) break;
+    }
+    pos = p;
+}
+
+void integrate_and_bounce_steps(float* x, float* y, float* vx, float* vy, const float* steps, int count,
+                                float delta_time, float bounds) {
+    simd_f32 dt = simd_splat(delta_time);
+    simd_f32 lo = simd_splat(-bounds);
+    simd_f32 hi = simd_splat(bounds);
+    simd_f32 one = simd_splat(1.0f);
+    simd_f32 sign_bit = simd_splat(-0.0f);
+
+    int i = 0;
+    for (; i + SIMD_WIDTH <= count; i += SIMD_WIDTH) {
+        simd_f32 n = simd_load(steps + i);
+        simd_f32 pvx = simd_load(vx + i);
+        simd_f32 pvy = simd_load(vy + i);
+        simd_f32 px = simd_add(simd_load(x + i), simd_mul(simd_mul(pvx, dt), n));
+        simd_f32 py = simd_add(simd_load(y + i), simd_mul(simd_mul(pvy, dt), n));
+
+        // Runs of several steps that leave the world are rare; solve them
+        // one entity at a time
+        simd_f32 outside = simd_or(simd_or(simd_cmplt(px, lo), simd_cmpgt(px, hi)),
+                                   simd_or(simd_cmplt(py, lo), simd_cmpgt(py, hi)));
+        if (simd_any(simd_and(outside, simd_cmpgt(n, one)))) {
+            integrate_and_bounce_steps_reference(x + i, y + i, vx + i, vy + i, steps + i, SIMD_WIDTH,
+                                                 delta_time, bounds);
+            continue;
+        }
+
+        bounce_axis(px, pvx, lo, hi, sign_bit);
+        bounce_axis(py, pvy, lo, hi, sign_bit);
+
+        simd_store(x + i, px);
+        simd_store(y + i, py);
+        simd_store(vx + i, pvx);
+        simd_store(vy + i, pvy);
+    }
+
+    if (i < count) {
+        integrate_and_bounce_steps_reference(x + i, y + i, vx + i, vy + i, steps + i, count - i, delta_time, bounds);
+    }
+}
+
+void integrate_and_bounce_steps_reference(float* x, float* y, float* vx, float* vy, const float* steps,
+                                          int count, float delta_time, float bounds) {
+    for (int i = 0; i < count; i++) {
+        advance_axis(x[i], vx[i], steps[i], delta_time, bounds);
+        advance_axis(y[i], vy[i], steps[i], delta_time, bounds);
+    }
+}
+
+const char* movement_kernel_name() {
+    return SIMD_NAME;
+}
@@ -0,0 +1,32 @@
+#ifndef MOVEMENT_H
+#define MOVEMENT_H
+
+// Integrates positions by velocity and bounces entities off the square world
+// [-bounds, bounds]: out-of-range positions are clamped to the edge and the
+// matching velocity component is reflected.
+// Operates on SoA arrays in place and processes SIMD_WIDTH entities per step.
+void integrate_and_bounce(float* x, float* y, float* vx, float* vy, int count,
+                          float delta_time, float bounds);
+
+// Straightforward branchy scalar version of the same step. The vector kernel
+// must match it bit for bit.
+void integrate_and_bounce_reference(float* x, float* y, float* vx, float* vy, int count,
+                                    float delta_time, float bounds);
+
+// Advances each entity by steps[i] whole steps (a non-negative integer held
+// in a float) at its current velocity, bouncing off the edges as that many
+// integrate_and_bounce calls would. A straight run is one multiply-add and a
+// run that leaves the world is solved from wall to wall, so the result agrees
+// with stepping one at a time up to rounding; one step matches
+// integrate_and_bounce bit for bit and zero steps leave the entity alone.
+void integrate_and_bounce_steps(float* x, float* y, float* vx, float* vy, const float* steps, int count,
+                                float delta_time, float bounds);
+
+// Scalar version of the same. The vector kernel must match it bit for bit.
+void integrate_and_bounce_steps_reference(float* x, float* y, float* vx, float* vy, const float* steps,
+                                          int count, float delta_time, float bounds);
+
+// Name of the instruction set integrate_and_bounce was compiled for.
+const char* movement_kernel_name();
+
+#endif
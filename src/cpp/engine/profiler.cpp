@@ -0,0 +1,132 @@
+#include "profiler.h"
+#include <cstring>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#else
+#include <chrono>
+#include <cstdio>
+#endif
+
+// One timer span for trace dumps; section PROFILE_SECTION_COUNT marks a whole frame
+struct ProfilerSpan {
+    double start_us;
+    float duration_us;
+    uint32_t section;
+};
+
+static const char* g_section_names[PROFILE_SECTION_COUNT + 1] = {
+    "sim", "cull", "render", "upload", "draw", "context_switch", "frame"
+};
+
+static ProfilerFrame g_frames[PROFILER_FRAMES];
+static int g_frame_count = 0;
+static ProfilerFrame g_current;
+static double g_frame_start_us = 0.0;
+static bool g_in_frame = false;
+
+static ProfilerSpan g_spans[PROFILER_EVENTS];
+static int g_span_count = 0; // total recorded, the ring wraps at PROFILER_EVENTS
+
+static void record_span(uint32_t section, double start_us, double end_us) {
+    ProfilerSpan& span = g_spans[g_span_count % PROFILER_EVENTS];
+    span.start_us = start_us;
+    span.duration_us = (float)(end_us - start_us);
+    span.section = section;
+    g_span_count++;
+}
+
+double profiler_now_us() {
+#ifdef __EMSCRIPTEN__
+    return emscripten_get_now() * 1000.0;
+#else
+    using namespace std::chrono;
+    return duration<double, std::micro>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+void profiler_add_span(ProfileSection section, double start_us, double end_us) {
+    if (!g_in_frame) return;
+    g_current.section_ms[section] += (float)((end_us - start_us) * 1e-3);
+    record_span((uint32_t)section, start_us, end_us);
+}
+
+void profiler_count_gl_calls(int count) {
+    g_current.gl_calls += (uint32_t)count;
+}
+
+void profiler_count_draw_calls(int count) {
+    g_current.draw_calls += (uint32_t)count;
+}
+
+extern "C" {
+    void profiler_begin_frame() {
+        memset(&g_current, 0, sizeof(g_current));
+        g_current.frame_index = (uint32_t)g_frame_count;
+        g_frame_start_us = profiler_now_us();
+        g_in_frame = true;
+    }
+
+    void profiler_end_frame() {
+        if (!g_in_frame) return;
+        double end_us = profiler_now_us();
+        g_current.frame_ms = (float)((end_us - g_frame_start_us) * 1e-3);
+        record_span(PROFILE_SECTION_COUNT, g_frame_start_us, end_us);
+
+        g_frames[g_frame_count % PROFILER_FRAMES] = g_current;
+        g_frame_count++;
+        g_in_frame = false;
+    }
+
+    const ProfilerFrame* get_profiler_frames() {
+        return g_frames;
+    }
+
+    int get_profiler_frame_capacity() {
+        return PROFILER_FRAMES;
+    }
+
+    int get_profiler_frame_count() {
+        return g_frame_count;
+    }
+}
+
+#ifndef __EMSCRIPTEN__
+bool profiler_write_csv(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+
+    fprintf(file, "frame,frame_ms");
+    for (int s = 0; s < PROFILE_SECTION_COUNT; s++) fprintf(file, ",%s_ms", g_section_names[s]);
+    fprintf(file, ",gl_calls,draw_calls\n");
+
+    // Oldest frame still in the ring first
+    int first = g_frame_count > PROFILER_FRAMES ? g_frame_count - PROFILER_FRAMES : 0;
+    for (int n = first; n < g_frame_count; n++) {
+        const ProfilerFrame& frame = g_frames[n % PROFILER_FRAMES];
+        fprintf(file, "%u,%.4f", frame.frame_index, frame.frame_ms);
+        for (int s = 0; s < PROFILE_SECTION_COUNT; s++) fprintf(file, ",%.4f", frame.section_ms[s]);
+        fprintf(file, ",%u,%u\n", frame.gl_calls, frame.draw_calls);
+    }
+
+    fclose(file);
+    return true;
+}
+
+bool profiler_write_chrome_trace(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) return false;
+
+    fprintf(file, "{\"traceEvents\":[");
+    int first = g_span_count > PROFILER_EVENTS ? g_span_count - PROFILER_EVENTS : 0;
+    for (int n = first; n < g_span_count; n++) {
+        const ProfilerSpan& span = g_spans[n % PROFILER_EVENTS];
+        fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":1}",
+                n == first ? "" : ",", g_section_names[span.section], span.start_us, span.duration_us);
+    }
+    fprintf(file, "\n],\"displayTimeUnit\":\"ms\"}\n");
+
+    fclose(file);
+    return true;
+}
+#endif
@@ -0,0 +1,99 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdint.h>
+
+// Frame profiler. Scoped timers add their time to a section of the current
+// frame, and each finished frame is stored in a fixed-size ring. The timers
+// and counters are only compiled in when ENABLE_PROFILER is defined (CMake
+// -DSIM_ENABLE_PROFILER=ON, or "build.bat profile"); otherwise the macros
+// below expand to nothing and the ring stays empty. Main thread only.
+
+enum ProfileSection {
+    PROFILE_SIM = 0,            // simulation steps, or waiting for the async step
+    PROFILE_CULL = 1,           // per-viewport culling
+    PROFILE_RENDER = 2,         // whole viewport render, includes upload and draw
+    PROFILE_UPLOAD = 3,         // buffer uploads
+    PROFILE_DRAW = 4,           // draw call submission
+    PROFILE_CONTEXT_SWITCH = 5, // making a viewport's WebGL context current
+    PROFILE_SECTION_COUNT = 6
+};
+
+#define PROFILER_FRAMES 256  // frames kept in the ring
+#define PROFILER_EVENTS 4096 // individual timer spans kept for trace dumps
+
+// One frame of timings. Every field is 32 bits, so in the WASM build JS can
+// view the ring as a Float32Array/Uint32Array of PROFILER_FRAME_WORDS words
+// per frame.
+struct ProfilerFrame {
+    uint32_t frame_index;
+    float frame_ms;
+    float section_ms[PROFILE_SECTION_COUNT];
+    uint32_t gl_calls;
+    uint32_t draw_calls;
+};
+
+#define PROFILER_FRAME_WORDS 10
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void profiler_begin_frame();
+void profiler_end_frame();
+
+// The ring of the last PROFILER_FRAMES frames. Frame n (counting from 0) is
+// at slot n % capacity; count is the total number of frames recorded.
+const struct ProfilerFrame* get_profiler_frames();
+int get_profiler_frame_capacity();
+int get_profiler_frame_count();
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef __cplusplus
+
+double profiler_now_us();
+void profiler_add_span(ProfileSection section, double start_us, double end_us);
+void profiler_count_gl_calls(int count);
+void profiler_count_draw_calls(int count);
+
+#ifndef __EMSCRIPTEN__
+// Native dumps of the ring: one CSV row per frame, or the timer spans as
+// Chrome trace events (load in chrome://tracing or Perfetto)
+bool profiler_write_csv(const char* path);
+bool profiler_write_chrome_trace(const char* path);
+#endif
+
+#ifdef ENABLE_PROFILER
+
+struct ProfileScope {
+    ProfileSection section;
+    double start_us;
+
+    explicit ProfileScope(ProfileSection s) : section(s), start_us(profiler_now_us()) {}
+    ~ProfileScope() { profiler_add_span(section, start_us, profiler_now_us()); }
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(section) ProfileScope PROFILE_CONCAT(profile_scope_, __LINE__)(section)
+#define PROFILE_BEGIN_FRAME() profiler_begin_frame()
+#define PROFILE_END_FRAME() profiler_end_frame()
+#define PROFILE_GL_CALLS(count) profiler_count_gl_calls(count)
+#define PROFILE_DRAW_CALLS(count) profiler_count_draw_calls(count)
+
+#else
+
+#define PROFILE_SCOPE(section) ((void)0)
+#define PROFILE_BEGIN_FRAME() ((void)0)
+#define PROFILE_END_FRAME() ((void)0)
+#define PROFILE_GL_CALLS(count) ((void)0)
+#define PROFILE_DRAW_CALLS(count) ((void)0)
+
+#endif
+
+#endif
+
+#endif
@@ -1,13 +1,27 @@
 #include "renderer.h"
-#include <emscripten.h>
-#include <emscripten/html5.h>
-#include <GLES3/gl3.h>
+#include "culling.h"
+#include "indicators.h"
+#include "profiler.h"
+#include "gl_backend.h"
 #include <cmath>
 #include <algorithm>
+#include <vector>
+
+#ifdef __EMSCRIPTEN__
+#include <emscripten.h>
+#else
+#define EMSCRIPTEN_KEEPALIVE
+#endif
 
 static int g_canvas_width = 400; // Split screen, so half width
 static int g_canvas_height = 400; // Split screen, so half height
 static float g_grid_size = 50.0f;
+static int g_grid_mode = GRID_MODE_PROCEDURAL;
+
+// Single-context mode: every viewport renders through context 0 into its own
+// quadrant of one canvas that is twice the viewport size in each direction
+static bool g_shared_context = false;
+static int g_viewport_origin[2] = {0, 0}; // window coordinates of the current viewport
 
 // Team colors (RGB)
 static float g_team_colors[4][3] = {
@@ -17,48 +31,155 @@ static float g_team_colors[4][3] = {
     {0.6f, 0.4f, 0.2f}  // Brown
 };
 
+static const float g_grid_color[3] = {0.12f, 0.12f, 0.12f}; // Soft dark gray
+static const float g_background_color[3] = {0.08f, 0.08f, 0.08f}; // Soft dark background
+static const float g_default_color[3] = {0.8f, 0.8f, 0.9f}; // Light gray/white
+
+// Attribute locations are fixed in the shaders so VAOs never need to query them
+#define ATTRIB_POSITION 0
+#define ATTRIB_COLOR 1
+#define ATTRIB_INSTANCE_X 2
+#define ATTRIB_INSTANCE_Y 3
+#define ATTRIB_INSTANCE_TEAM 4
+
 // Simple shader sources
 static const char* vertex_shader_source = R"(#version 300 es
 precision mediump float;
-in vec2 a_position;
+layout(location = 0) in vec2 a_position;
+layout(location = 1) in vec3 a_color;
 uniform vec2 u_resolution;
 uniform vec2 u_offset;
+out vec3 v_color;
 
 void main() {
     vec2 position = (a_position + u_offset) / u_resolution * 2.0 - 1.0;
     position.y = -position.y;
     gl_Position = vec4(position, 0.0, 1.0);
+    v_color = a_color;
 }
 )";
 
 static const char* fragment_shader_source = R"(#version 300 es
 precision mediump float;
-uniform vec3 u_color;
+in vec3 v_color;
+out vec4 fragColor;
+
+void main() {
+    fragColor = vec4(v_color, 1.0);
+}
+)";
+
+// Entity squares: the unit quad from player_vao is drawn once per instance,
+// offset by the instance position and colored from the team table. Instance
+// attributes come straight from the simulation's SoA arrays. Slot 4 of
+// u_team_colors holds the default color for out-of-range team indices.
+static const char* instance_vertex_shader_source = R"(#version 300 es
+precision mediump float;
+layout(location = 0) in vec2 a_position;
+layout(location = 2) in float a_instance_x;
+layout(location = 3) in float a_instance_y;
+layout(location = 4) in float a_instance_team;
+uniform vec2 u_resolution;
+uniform vec2 u_offset;
+uniform vec3 u_team_colors[5];
+out vec3 v_color;
+
+void main() {
+    vec2 position = (a_position + vec2(a_instance_x, a_instance_y) + u_offset) / u_resolution * 2.0 - 1.0;
+    position.y = -position.y;
+    gl_Position = vec4(position, 0.0, 1.0);
+
+    int team = int(a_instance_team);
+    v_color = u_team_colors[(team >= 0 && team < 4) ? team : 4];
+}
+)";
+
+// Procedural grid: one triangle covering the whole viewport, generated from
+// gl_VertexID so it needs no vertex buffer. The fragment shader measures the
+// distance to the nearest grid line in screen pixels using derivatives, so
+// lines stay one pixel wide at any zoom and fade out once they get too dense.
+static const char* grid_vertex_shader_source = R"(#version 300 es
+precision mediump float;
+
+void main() {
+    vec2 corner = vec2(float((gl_VertexID & 1) << 2), float((gl_VertexID & 2) << 1)) - 1.0;
+    gl_Position = vec4(corner, 0.0, 1.0);
+}
+)";
+
+static const char* grid_fragment_shader_source = R"(#version 300 es
+precision highp float;
+uniform vec2 u_resolution;
+uniform vec2 u_offset;
+uniform vec2 u_viewport_origin;
+uniform float u_grid_size;
+uniform vec3 u_grid_color;
+uniform vec3 u_background_color;
 out vec4 fragColor;
 
 void main() {
-    fragColor = vec4(u_color, 1.0);
+    // Back from window pixels (bottom-left origin) to world coordinates
+    vec2 local = gl_FragCoord.xy - u_viewport_origin;
+    vec2 pixel = vec2(local.x, u_resolution.y - local.y);
+    vec2 cell = (pixel - u_offset) / u_grid_size;
+
+    // Distance to the nearest line in pixels along each axis
+    vec2 cell_per_pixel = fwidth(cell);
+    vec2 line_distance = abs(fract(cell - 0.5) - 0.5) / cell_per_pixel;
+    float line = 1.0 - min(min(line_distance.x, line_distance.y), 1.0);
+
+    // Fade out when lines would be fewer than 8 pixels apart
+    float spacing = 1.0 / max(cell_per_pixel.x, cell_per_pixel.y);
+    line *= smoothstep(3.0, 8.0, spacing);
+
+    fragColor = vec4(mix(u_background_color, u_grid_color, line), 1.0);
 }
 )";
 
+// One vertex of the streamed per-frame geometry
+struct StreamVertex {
+    float x, y;
+    float r, g, b;
+};
+
+// Initial size of each context's streaming vertex buffer
+#define STREAM_BUFFER_BYTES (256 * 1024)
+// Initial size of each context's per-instance attribute buffer
+#define INSTANCE_BUFFER_BYTES (64 * 1024)
+
 // Per-context renderer state (one per WebGL context)
 struct RendererState {
     GLuint shader_program;
     GLuint grid_vao;
     GLuint player_vao;
+    GLuint stream_vao;
+    GLuint stream_vbo;
+    GLsizeiptr stream_capacity; // bytes
+    GLsizeiptr stream_head;     // next free byte in the current buffer storage
+    GLint resolution_loc;
+    GLint offset_loc;
+    GLuint instance_program;
+    GLuint instance_vbo;
+    GLsizeiptr instance_capacity; // bytes
+    GLint instance_resolution_loc;
+    GLint instance_offset_loc;
+    GLuint grid_program;
+    GLint grid_resolution_loc;
+    GLint grid_offset_loc;
+    GLint grid_size_loc;
+    GLint grid_origin_loc;
     bool initialized;
 };
 
-static RendererState g_renderer_states[4] = {
-    {0, 0, 0, false},
-    {0, 0, 0, false},
-    {0, 0, 0, false},
-    {0, 0, 0, false}
-};
+static RendererState g_renderer_states[4] = {};
+
+// CPU-side batches for the frame being built, shared by all contexts since
+// viewports are rendered one after another
+static std::vector<StreamVertex> g_line_batch;
+static std::vector<StreamVertex> g_triangle_batch;
 
-static void draw_directional_arrows(RendererState& state, float center_ai_x, float center_ai_y,
-                                    float ai_positions[4][2], int ai_teams[4], int viewport_index,
-                                    float offset_x, float offset_y, GLint color_loc, GLint offset_loc);
+// Off-screen arrow clustering scratch, reused by every viewport
+static IndicatorBuffers g_indicator_buffers;
 
 static GLuint compile_shader(GLenum type, const char* source) {
     GLuint shader = glCreateShader(type);
@@ -74,9 +195,9 @@ static GLuint compile_shader(GLenum type, const char* source) {
     return shader;
 }
 
-static GLuint create_shader_program() {
-    GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_shader_source);
-    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_shader_source);
+static GLuint create_shader_program(const char* vertex_source, const char* fragment_source) {
+    GLuint vertex_shader = compile_shader(GL_VERTEX_SHADER, vertex_source);
+    GLuint fragment_shader = compile_shader(GL_FRAGMENT_SHADER, fragment_source);
     
     if (!vertex_shader || !fragment_shader) {
         return 0;
@@ -105,7 +226,8 @@ static void create_grid_vao(RendererState& state) {
     glGenVertexArrays(1, &state.grid_vao);
     glBindVertexArray(state.grid_vao);
     
-    // We'll draw grid lines dynamically, so just set up the VAO structure
+    // Both grid modes generate their vertices elsewhere (streamed lines or
+    // gl_VertexID), so the VAO has no attributes
     glBindVertexArray(0);
 }
 
@@ -127,14 +249,271 @@ static void create_player_vao(RendererState& state) {
     glGenBuffers(1, &vbo);
     glBindBuffer(GL_ARRAY_BUFFER, vbo);
     glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-    
-    GLint pos_attr = glGetAttribLocation(state.shader_program, "a_position");
-    glEnableVertexAttribArray(pos_attr);
-    glVertexAttribPointer(pos_attr, 2, GL_FLOAT, GL_FALSE, 0, 0);
-    
+
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glVertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, 0, 0);
+
+    // Per-instance x, y and team, advanced once per square. The buffer holds
+    // the three arrays back to back; pointers are set when the size is known.
+    glGenBuffers(1, &state.instance_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, state.instance_vbo);
+    glBufferData(GL_ARRAY_BUFFER, INSTANCE_BUFFER_BYTES, nullptr, GL_STREAM_DRAW);
+    state.instance_capacity = INSTANCE_BUFFER_BYTES;
+
+    glEnableVertexAttribArray(ATTRIB_INSTANCE_X);
+    glEnableVertexAttribArray(ATTRIB_INSTANCE_Y);
+    glEnableVertexAttribArray(ATTRIB_INSTANCE_TEAM);
+    glVertexAttribDivisor(ATTRIB_INSTANCE_X, 1);
+    glVertexAttribDivisor(ATTRIB_INSTANCE_Y, 1);
+    glVertexAttribDivisor(ATTRIB_INSTANCE_TEAM, 1);
+
     glBindVertexArray(0);
 }
 
+static void create_stream_vao(RendererState& state) {
+    // One dynamic VBO per context that every frame's geometry is streamed into
+    glGenVertexArrays(1, &state.stream_vao);
+    glBindVertexArray(state.stream_vao);
+
+    glGenBuffers(1, &state.stream_vbo);
+    glBindBuffer(GL_ARRAY_BUFFER, state.stream_vbo);
+    glBufferData(GL_ARRAY_BUFFER, STREAM_BUFFER_BYTES, nullptr, GL_STREAM_DRAW);
+    state.stream_capacity = STREAM_BUFFER_BYTES;
+    state.stream_head = 0;
+
+    glEnableVertexAttribArray(ATTRIB_POSITION);
+    glVertexAttribPointer(ATTRIB_POSITION, 2, GL_FLOAT, GL_FALSE, sizeof(StreamVertex), (void*)0);
+    glEnableVertexAttribArray(ATTRIB_COLOR);
+    glVertexAttribPointer(ATTRIB_COLOR, 3, GL_FLOAT, GL_FALSE, sizeof(StreamVertex), (void*)(2 * sizeof(float)));
+
+    glBindVertexArray(0);
+}
+
+static const float* team_color(int team) {
+    if (team >= 0 && team < 4) {
+        return g_team_colors[team];
+    }
+    return g_default_color;
+}
+
+static void push_vertex(std::vector<StreamVertex>& batch, float x, float y, const float color[3]) {
+    StreamVertex v = {x, y, color[0], color[1], color[2]};
+    batch.push_back(v);
+}
+
+static void push_line(float x0, float y0, float x1, float y1, const float color[3]) {
+    push_vertex(g_line_batch, x0, y0, color);
+    push_vertex(g_line_batch, x1, y1, color);
+}
+
+static void push_square(float center_x, float center_y, float size, const float color[3]) {
+    float x0 = center_x - size/2, x1 = center_x + size/2;
+    float y0 = center_y - size/2, y1 = center_y + size/2;
+
+    // Two triangles, same corners as the old triangle fan
+    push_vertex(g_triangle_batch, x0, y0, color);
+    push_vertex(g_triangle_batch, x1, y0, color);
+    push_vertex(g_triangle_batch, x1, y1, color);
+    push_vertex(g_triangle_batch, x0, y0, color);
+    push_vertex(g_triangle_batch, x1, y1, color);
+    push_vertex(g_triangle_batch, x0, y1, color);
+}
+
+static void push_triangle(float x0, float y0, float x1, float y1, float x2, float y2, const float color[3]) {
+    push_vertex(g_triangle_batch, x0, y0, color);
+    push_vertex(g_triangle_batch, x1, y1, color);
+    push_vertex(g_triangle_batch, x2, y2, color);
+}
+
+// Upload a batch into the context's ring buffer and draw it with one call.
+// Writes go to the next unused range; when the buffer is full its storage is
+// orphaned so the driver can hand out fresh memory instead of waiting on draws
+// that still read the old contents.
+static void draw_stream_batch(RendererState& state, GLenum mode, std::vector<StreamVertex>& batch) {
+    if (batch.empty()) return;
+
+    GLsizeiptr bytes = (GLsizeiptr)(batch.size() * sizeof(StreamVertex));
+
+    glBindVertexArray(state.stream_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, state.stream_vbo);
+
+    {
+        PROFILE_SCOPE(PROFILE_UPLOAD);
+        if (bytes > state.stream_capacity) {
+            // Grow to fit the largest batch seen so far
+            while (state.stream_capacity < bytes) state.stream_capacity *= 2;
+            glBufferData(GL_ARRAY_BUFFER, state.stream_capacity, nullptr, GL_STREAM_DRAW);
+            state.stream_head = 0;
+        } else if (state.stream_head + bytes > state.stream_capacity) {
+            glBufferData(GL_ARRAY_BUFFER, state.stream_capacity, nullptr, GL_STREAM_DRAW);
+            state.stream_head = 0;
+        }
+
+        glBufferSubData(GL_ARRAY_BUFFER, state.stream_head, bytes, batch.data());
+    }
+
+    {
+        PROFILE_SCOPE(PROFILE_DRAW);
+        glDrawArrays(mode, (GLint)(state.stream_head / (GLsizeiptr)sizeof(StreamVertex)), (GLsizei)batch.size());
+    }
+
+    state.stream_head += bytes;
+    batch.clear();
+}
+
+// Draw entity squares with a single instanced call, uploading the x, y and
+// team arrays directly as three consecutive ranges of the instance buffer.
+// Re-specifying the buffer orphans the storage the previous viewport's draw
+// may still be reading.
+static void draw_instances(RendererState& state, const float* xs, const float* ys, const int32_t* teams,
+                           int count, float offset_x, float offset_y) {
+    if (count <= 0) return;
+
+    GLsizeiptr array_bytes = (GLsizeiptr)count * 4;
+    GLsizeiptr bytes = array_bytes * 3;
+
+    glUseProgram(state.instance_program);
+    glUniform2f(state.instance_resolution_loc, (float)g_canvas_width, (float)g_canvas_height);
+    glUniform2f(state.instance_offset_loc, offset_x, offset_y);
+
+    glBindVertexArray(state.player_vao);
+    glBindBuffer(GL_ARRAY_BUFFER, state.instance_vbo);
+    {
+        PROFILE_SCOPE(PROFILE_UPLOAD);
+        while (state.instance_capacity < bytes) state.instance_capacity *= 2;
+        glBufferData(GL_ARRAY_BUFFER, state.instance_capacity, nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, array_bytes, xs);
+        glBufferSubData(GL_ARRAY_BUFFER, array_bytes, array_bytes, ys);
+        glBufferSubData(GL_ARRAY_BUFFER, 2 * array_bytes, array_bytes, teams);
+    }
+
+    glVertexAttribPointer(ATTRIB_INSTANCE_X, 1, GL_FLOAT, GL_FALSE, 0, (void*)0);
+    glVertexAttribPointer(ATTRIB_INSTANCE_Y, 1, GL_FLOAT, GL_FALSE, 0, (void*)array_bytes);
+    glVertexAttribPointer(ATTRIB_INSTANCE_TEAM, 1, GL_INT, GL_FALSE, 0, (void*)(2 * array_bytes));
+
+    PROFILE_SCOPE(PROFILE_DRAW);
+    glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, (GLsizei)count);
+}
+
+// Queue grid lines covering the area around (center_x, center_y)
+static void build_grid_lines(float center_x, float center_y, float grid_size) {
+    int grid_start_x = (int)((center_x - g_canvas_width / 2.0f) / grid_size) - 1;
+    int grid_end_x = (int)((center_x + g_canvas_width / 2.0f) / grid_size) + 1;
+    int grid_start_y = (int)((center_y - g_canvas_height / 2.0f) / grid_size) - 1;
+    int grid_end_y = (int)((center_y + g_canvas_height / 2.0f) / grid_size) + 1;
+
+    // Vertical grid lines
+    for (int x = grid_start_x; x <= grid_end_x; x++) {
+        float line_x = x * grid_size;
+        push_line(line_x, grid_start_y * grid_size, line_x, (grid_end_y + 1) * grid_size, g_grid_color);
+    }
+
+    // Horizontal grid lines
+    for (int y = grid_start_y; y <= grid_end_y; y++) {
+        float line_y = y * grid_size;
+        push_line(grid_start_x * grid_size, line_y, (grid_end_x + 1) * grid_size, line_y, g_grid_color);
+    }
+}
+
+// Draw the grid for a camera offset in the current grid mode
+static void draw_grid(RendererState& state, float center_x, float center_y, float offset_x, float offset_y,
+                      float grid_size) {
+    if (g_grid_mode == GRID_MODE_PROCEDURAL) {
+        glUseProgram(state.grid_program);
+        glUniform2f(state.grid_resolution_loc, (float)g_canvas_width, (float)g_canvas_height);
+        glUniform2f(state.grid_offset_loc, offset_x, offset_y);
+        glUniform1f(state.grid_size_loc, grid_size);
+        glUniform2f(state.grid_origin_loc, (float)g_viewport_origin[0], (float)g_viewport_origin[1]);
+
+        glBindVertexArray(state.grid_vao);
+        PROFILE_SCOPE(PROFILE_DRAW);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    } else {
+        glUseProgram(state.shader_program);
+        build_grid_lines(center_x, center_y, grid_size);
+        draw_stream_batch(state, GL_LINES, g_line_batch);
+    }
+}
+
+// Arrows for entities outside the viewport. Nearby entities of one team are
+// merged into a single arrow that grows with the number it stands for, and
+// every arrow goes into the same triangle batch.
+static void build_directional_arrows(float center_ai_x, float center_ai_y, const CullSet& offscreen) {
+    const float viewport_half_width = g_canvas_width / 2.0f;
+    const float viewport_half_height = g_canvas_height / 2.0f;
+    const float base_arrow_size = 15.0f;
+    const float edge_margin = 20.0f; // Distance from edge
+    const float segment_length = 40.0f; // Border length merged into one arrow
+
+    float viewport_left = center_ai_x - viewport_half_width;
+    float viewport_right = center_ai_x + viewport_half_width;
+    float viewport_top = center_ai_y - viewport_half_height;
+    float viewport_bottom = center_ai_y + viewport_half_height;
+
+    int num_clusters = build_indicator_clusters(g_indicator_buffers, offscreen.x, offscreen.y, offscreen.team,
+                                                offscreen.count, center_ai_x, center_ai_y,
+                                                viewport_half_width, viewport_half_height, segment_length);
+
+    for (int c = 0; c < num_clusters; c++) {
+        const IndicatorCluster& cluster = g_indicator_buffers.clusters[c];
+
+        // Clamp arrow position to viewport edges with margin
+        float edge_x = std::max(viewport_left + edge_margin, std::min(viewport_right - edge_margin, cluster.x));
+        float edge_y = std::max(viewport_top + edge_margin, std::min(viewport_bottom - edge_margin, cluster.y));
+
+        // Bigger arrows for bigger groups: double size at 16 entities, capped
+        float arrow_size = base_arrow_size * std::min(1.0f + 0.25f * log2f((float)cluster.count), 2.5f);
+
+        // Arrow tip (pointing outward)
+        float tip_x = edge_x + cluster.dir_x * arrow_size;
+        float tip_y = edge_y + cluster.dir_y * arrow_size;
+
+        // Arrow base (two points forming the base)
+        float perp_x = -cluster.dir_y;
+        float perp_y = cluster.dir_x;
+        float base_half_width = arrow_size * 0.5f;
+
+        float base1_x = edge_x + perp_x * base_half_width;
+        float base1_y = edge_y + perp_y * base_half_width;
+        float base2_x = edge_x - perp_x * base_half_width;
+        float base2_y = edge_y - perp_y * base_half_width;
+
+        // Use team color for arrow
+        push_triangle(tip_x, tip_y, base1_x, base1_y, base2_x, base2_y, team_color(cluster.team));
+    }
+}
+
+// Point rasterization at a viewport's area: the whole canvas for per-viewport
+// contexts, or its quadrant with scissoring (so clears stay inside) when all
+// viewports share one canvas. Quadrants follow the page layout: red top-left,
+// blue top-right, purple bottom-left, brown bottom-right.
+static void set_viewport_area(int viewport_index) {
+    int x = 0, y = 0;
+    if (g_shared_context) {
+        x = (viewport_index % 2) * g_canvas_width;
+        y = (1 - viewport_index / 2) * g_canvas_height; // GL origin is bottom-left
+        glEnable(GL_SCISSOR_TEST);
+        glScissor(x, y, g_canvas_width, g_canvas_height);
+    } else {
+        glDisable(GL_SCISSOR_TEST);
+    }
+
+    glViewport(x, y, g_canvas_width, g_canvas_height);
+    g_viewport_origin[0] = x;
+    g_viewport_origin[1] = y;
+}
+
+// Common per-viewport setup: clear and set the stream program's camera uniforms
+static void begin_viewport(RendererState& state, float offset_x, float offset_y) {
+    // Clear with soft dark background
+    glClearColor(g_background_color[0], g_background_color[1], g_background_color[2], 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glUseProgram(state.shader_program);
+    glUniform2f(state.resolution_loc, (float)g_canvas_width, (float)g_canvas_height);
+    glUniform2f(state.offset_loc, offset_x, offset_y);
+}
+
 extern "C" {
     void init_renderer(int canvas_width, int canvas_height, int context_index) {
         if (context_index < 0 || context_index >= 4) return;
@@ -144,19 +523,47 @@ extern "C" {
         g_canvas_width = canvas_width;
         g_canvas_height = canvas_height;
         
-        // Create shader program for this context
-        state.shader_program = create_shader_program();
-        if (!state.shader_program) {
+        // Create shader programs for this context
+        state.shader_program = create_shader_program(vertex_shader_source, fragment_shader_source);
+        state.instance_program = create_shader_program(instance_vertex_shader_source, fragment_shader_source);
+        state.grid_program = create_shader_program(grid_vertex_shader_source, grid_fragment_shader_source);
+        if (!state.shader_program || !state.instance_program || !state.grid_program) {
             return;
         }
+
+        // Uniform locations never change after linking, so look them up once
+        state.resolution_loc = glGetUniformLocation(state.shader_program, "u_resolution");
+        state.offset_loc = glGetUniformLocation(state.shader_program, "u_offset");
+        state.instance_resolution_loc = glGetUniformLocation(state.instance_program, "u_resolution");
+        state.instance_offset_loc = glGetUniformLocation(state.instance_program, "u_offset");
+
+        // The team color table is constant, so upload it once per context
+        float team_colors[5][3];
+        for (int team = 0; team < 5; team++) {
+            const float* color = team_color(team);
+            team_colors[team][0] = color[0];
+            team_colors[team][1] = color[1];
+            team_colors[team][2] = color[2];
+        }
+        glUseProgram(state.instance_program);
+        glUniform3fv(glGetUniformLocation(state.instance_program, "u_team_colors"), 5, &team_colors[0][0]);
+
+        state.grid_resolution_loc = glGetUniformLocation(state.grid_program, "u_resolution");
+        state.grid_offset_loc = glGetUniformLocation(state.grid_program, "u_offset");
+        state.grid_size_loc = glGetUniformLocation(state.grid_program, "u_grid_size");
+        state.grid_origin_loc = glGetUniformLocation(state.grid_program, "u_viewport_origin");
+        glUseProgram(state.grid_program);
+        glUniform3fv(glGetUniformLocation(state.grid_program, "u_grid_color"), 1, g_grid_color);
+        glUniform3fv(glGetUniformLocation(state.grid_program, "u_background_color"), 1, g_background_color);
         
         // Set up viewport
         glViewport(0, 0, canvas_width, canvas_height);
-        
+
         // Create VAOs for this context
         create_grid_vao(state);
         create_player_vao(state);
-        
+        create_stream_vao(state);
+
         state.initialized = true;
     }
 
@@ -167,386 +574,80 @@ extern "C" {
         // Viewport will be updated on next render when context is made current
     }
     
+    int get_viewport_width() {
+        return g_canvas_width;
+    }
+
+    int get_viewport_height() {
+        return g_canvas_height;
+    }
+
+    void set_grid_mode(int mode) {
+        g_grid_mode = mode == GRID_MODE_LINES ? GRID_MODE_LINES : GRID_MODE_PROCEDURAL;
+    }
+
+    void set_shared_context(int enabled) {
+        g_shared_context = enabled != 0;
+    }
+
     void render_frame(float player_x, float player_y, float grid_size) {
         // Use context 0's state for backward compatibility
         RendererState& state = g_renderer_states[0];
         if (!state.initialized || !state.shader_program) return;
-        
+
         g_grid_size = grid_size;
-        
-        // Clear with soft dark background
-        glClearColor(0.08f, 0.08f, 0.08f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-        
-        glUseProgram(state.shader_program);
-        
-        // Set resolution uniform
-        GLint resolution_loc = glGetUniformLocation(state.shader_program, "u_resolution");
-        glUniform2f(resolution_loc, (float)g_canvas_width, (float)g_canvas_height);
-        
+
+        set_viewport_area(0);
+
         // Calculate camera offset (center on player)
         float offset_x = -player_x + g_canvas_width / 2.0f;
         float offset_y = -player_y + g_canvas_height / 2.0f;
-        
-        // Draw subtle grid lines
-        glBindVertexArray(state.grid_vao);
-        
-        GLint color_loc = glGetUniformLocation(state.shader_program, "u_color");
-        GLint offset_loc = glGetUniformLocation(state.shader_program, "u_offset");
-        
+
+        begin_viewport(state, offset_x, offset_y);
+
         // Draw subtle grid lines
-        int grid_start_x = (int)((player_x - g_canvas_width / 2.0f) / grid_size) - 1;
-        int grid_end_x = (int)((player_x + g_canvas_width / 2.0f) / grid_size) + 1;
-        int grid_start_y = (int)((player_y - g_canvas_height / 2.0f) / grid_size) - 1;
-        int grid_end_y = (int)((player_y + g_canvas_height / 2.0f) / grid_size) + 1;
-        
-        // Set subtle dark gray color for grid lines
-        glUniform3f(color_loc, 0.12f, 0.12f, 0.12f); // Soft dark gray
-        
-        // Draw vertical grid lines
-        for (int x = grid_start_x; x <= grid_end_x; x++) {
-            float line_x = x * grid_size;
-            float line_start_y = grid_start_y * grid_size;
-            float line_end_y = (grid_end_y + 1) * grid_size;
-            
-            float vertices[] = {
-                line_x, line_start_y,
-                line_x, line_end_y
-            };
-            
-            GLuint vbo;
-            glGenBuffers(1, &vbo);
-            glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-            
-            GLint pos_attr = glGetAttribLocation(state.shader_program, "a_position");
-            glEnableVertexAttribArray(pos_attr);
-            glVertexAttribPointer(pos_attr, 2, GL_FLOAT, GL_FALSE, 0, 0);
-            
-            glUniform2f(offset_loc, offset_x, offset_y);
-            glDrawArrays(GL_LINES, 0, 2);
-            
-            glDeleteBuffers(1, &vbo);
-        }
-        
-        // Draw horizontal grid lines
-        for (int y = grid_start_y; y <= grid_end_y; y++) {
-            float line_y = y * grid_size;
-            float line_start_x = grid_start_x * grid_size;
-            float line_end_x = (grid_end_x + 1) * grid_size;
-            
-            float vertices[] = {
-                line_start_x, line_y,
-                line_end_x, line_y
-            };
-            
-            GLuint vbo;
-            glGenBuffers(1, &vbo);
-            glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-            
-            GLint pos_attr = glGetAttribLocation(state.shader_program, "a_position");
-            glEnableVertexAttribArray(pos_attr);
-            glVertexAttribPointer(pos_attr, 2, GL_FLOAT, GL_FALSE, 0, 0);
-            
-            glUniform2f(offset_loc, offset_x, offset_y);
-            glDrawArrays(GL_LINES, 0, 2);
-            
-            glDeleteBuffers(1, &vbo);
-        }
-        
+        draw_grid(state, player_x, player_y, offset_x, offset_y, grid_size);
+
         // Draw player square at player's world position
-        // Player square vertices are centered at origin, so we need to offset by player position
-        float player_size = 20.0f;
-        float player_vertices[] = {
-            player_x - player_size/2, player_y - player_size/2,
-            player_x + player_size/2, player_y - player_size/2,
-            player_x + player_size/2, player_y + player_size/2,
-            player_x - player_size/2, player_y + player_size/2
-        };
-        
-        GLuint player_vbo;
-        glGenBuffers(1, &player_vbo);
-        glBindBuffer(GL_ARRAY_BUFFER, player_vbo);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(player_vertices), player_vertices, GL_STATIC_DRAW);
-        
-        GLint pos_attr = glGetAttribLocation(state.shader_program, "a_position");
-        glEnableVertexAttribArray(pos_attr);
-        glVertexAttribPointer(pos_attr, 2, GL_FLOAT, GL_FALSE, 0, 0);
-        
-        glUniform3f(color_loc, 0.8f, 0.8f, 0.9f); // Light gray/white for player
-        glUniform2f(offset_loc, offset_x, offset_y);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-        
-        glDeleteBuffers(1, &player_vbo);
+        glUseProgram(state.shader_program);
+        push_square(player_x, player_y, 20.0f, g_default_color);
+        draw_stream_batch(state, GL_TRIANGLES, g_triangle_batch);
+
         glBindVertexArray(0);
     }
 
     void render_frame_for_viewport(float center_ai_x, float center_ai_y, float grid_size, int viewport_index,
-                                  float ai_positions[4][2], int ai_teams[4]) {
-        if (viewport_index < 0 || viewport_index >= 4) return;
-        
-        RendererState& state = g_renderer_states[viewport_index];
+                                  const ViewCull* view) {
+        if (viewport_index < 0 || viewport_index >= 4 || !view) return;
+        PROFILE_SCOPE(PROFILE_RENDER);
+
+        // Shaders, VAOs and buffers are shared by all viewports in single-context mode
+        RendererState& state = g_renderer_states[g_shared_context ? 0 : viewport_index];
         if (!state.initialized || !state.shader_program) return;
-        
+
         g_grid_size = grid_size;
 
         // Update viewport to match current canvas size
-        glViewport(0, 0, g_canvas_width, g_canvas_height);
-
-        // Clear with soft dark background
-        glClearColor(0.08f, 0.08f, 0.08f, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        glUseProgram(state.shader_program);
-
-        // Set resolution uniform
-        GLint resolution_loc = glGetUniformLocation(state.shader_program, "u_resolution");
-        glUniform2f(resolution_loc, (float)g_canvas_width, (float)g_canvas_height);
+        set_viewport_area(viewport_index);
 
         // Calculate camera offset (center on the specified AI)
         float offset_x = -center_ai_x + g_canvas_width / 2.0f;
         float offset_y = -center_ai_y + g_canvas_height / 2.0f;
 
-        // Draw subtle grid lines
-        glBindVertexArray(state.grid_vao);
-
-        GLint color_loc = glGetUniformLocation(state.shader_program, "u_color");
-        GLint offset_loc = glGetUniformLocation(state.shader_program, "u_offset");
+        begin_viewport(state, offset_x, offset_y);
 
         // Draw subtle grid lines
-        int grid_start_x = (int)((center_ai_x - g_canvas_width / 2.0f) / grid_size) - 1;
-        int grid_end_x = (int)((center_ai_x + g_canvas_width / 2.0f) / grid_size) + 1;
-        int grid_start_y = (int)((center_ai_y - g_canvas_height / 2.0f) / grid_size) - 1;
-        int grid_end_y = (int)((center_ai_y + g_canvas_height / 2.0f) / grid_size) + 1;
-
-        // Set subtle dark gray color for grid lines
-        glUniform3f(color_loc, 0.12f, 0.12f, 0.12f); // Soft dark gray
-
-        // Draw vertical grid lines
-        for (int x = grid_start_x; x <= grid_end_x; x++) {
-            float line_x = x * grid_size;
-            float line_start_y = grid_start_y * grid_size;
-            float line_end_y = (grid_end_y + 1) * grid_size;
-
-            float vertices[] = {
-                line_x, line_start_y,
-                line_x, line_end_y
-            };
-
-            GLuint vbo;
-            glGenBuffers(1, &vbo);
-            glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-            GLint pos_attr = glGetAttribLocation(state.shader_program, "a_position");
-            glEnableVertexAttribArray(pos_attr);
-            glVertexAttribPointer(pos_attr, 2, GL_FLOAT, GL_FALSE, 0, 0);
-
-            glUniform2f(offset_loc, offset_x, offset_y);
-            glDrawArrays(GL_LINES, 0, 2);
-
-            glDeleteBuffers(1, &vbo);
-        }
-
-        // Draw horizontal grid lines
-        for (int y = grid_start_y; y <= grid_end_y; y++) {
-            float line_y = y * grid_size;
-            float line_start_x = grid_start_x * grid_size;
-            float line_end_x = (grid_end_x + 1) * grid_size;
-
-            float vertices[] = {
-                line_start_x, line_y,
-                line_end_x, line_y
-            };
+        draw_grid(state, center_ai_x, center_ai_y, offset_x, offset_y, grid_size);
 
-            GLuint vbo;
-            glGenBuffers(1, &vbo);
-            glBindBuffer(GL_ARRAY_BUFFER, vbo);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-
-            GLint pos_attr = glGetAttribLocation(state.shader_program, "a_position");
-            glEnableVertexAttribArray(pos_attr);
-            glVertexAttribPointer(pos_attr, 2, GL_FLOAT, GL_FALSE, 0, 0);
-
-            glUniform2f(offset_loc, offset_x, offset_y);
-            glDrawArrays(GL_LINES, 0, 2);
-
-            glDeleteBuffers(1, &vbo);
-        }
-
-        // Draw all AI entities (including the centered one)
-        for (int i = 0; i < 4; i++) {
-            float ai_x = ai_positions[i][0];
-            float ai_y = ai_positions[i][1];
-            int team = ai_teams[i];
-
-            // Draw AI square
-            float ai_size = 20.0f;
-            float ai_vertices[] = {
-                ai_x - ai_size/2, ai_y - ai_size/2,
-                ai_x + ai_size/2, ai_y - ai_size/2,
-                ai_x + ai_size/2, ai_y + ai_size/2,
-                ai_x - ai_size/2, ai_y + ai_size/2
-            };
-
-            GLuint ai_vbo;
-            glGenBuffers(1, &ai_vbo);
-            glBindBuffer(GL_ARRAY_BUFFER, ai_vbo);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(ai_vertices), ai_vertices, GL_STATIC_DRAW);
-
-            GLint pos_attr = glGetAttribLocation(state.shader_program, "a_position");
-            glEnableVertexAttribArray(pos_attr);
-            glVertexAttribPointer(pos_attr, 2, GL_FLOAT, GL_FALSE, 0, 0);
-
-            // Use team color
-            if (team >= 0 && team < 4) {
-                glUniform3f(color_loc, g_team_colors[team][0], g_team_colors[team][1], g_team_colors[team][2]);
-            } else {
-                glUniform3f(color_loc, 0.8f, 0.8f, 0.9f); // Default light gray
-            }
-
-            glUniform2f(offset_loc, offset_x, offset_y);
-            glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
-
-            glDeleteBuffers(1, &ai_vbo);
-        }
+        // Draw the visible AI entities (including the centered one) in one instanced call
+        draw_instances(state, view->visible.x, view->visible.y, view->visible.team, view->visible.count,
+                       offset_x, offset_y);
 
         // Draw directional arrows for AI entities outside the viewport
-        draw_directional_arrows(state, center_ai_x, center_ai_y, ai_positions, ai_teams, viewport_index, offset_x, offset_y, color_loc, offset_loc);
+        glUseProgram(state.shader_program);
+        build_directional_arrows(center_ai_x, center_ai_y, view->offscreen);
+        draw_stream_batch(state, GL_TRIANGLES, g_triangle_batch);
 
         glBindVertexArray(0);
     }
-
-    static void draw_directional_arrows(RendererState& state, float center_ai_x, float center_ai_y,
-                                        float ai_positions[4][2], int ai_teams[4], int viewport_index,
-                                        float offset_x, float offset_y, GLint color_loc, GLint offset_loc) {
-        const float viewport_half_width = g_canvas_width / 2.0f;
-        const float viewport_half_height = g_canvas_height / 2.0f;
-        const float arrow_size = 15.0f;
-        const float edge_margin = 20.0f; // Distance from edge
-
-        for (int i = 0; i < 4; i++) {
-            // Skip the centered AI (don't show arrow for self)
-            if (i == viewport_index) continue;
-
-            float ai_x = ai_positions[i][0];
-            float ai_y = ai_positions[i][1];
-            int team = ai_teams[i];
-
-            // Calculate direction vector from center AI to this AI
-            float dx = ai_x - center_ai_x;
-            float dy = ai_y - center_ai_y;
-
-            // Check if AI is outside viewport bounds
-            float viewport_left = center_ai_x - viewport_half_width;
-            float viewport_right = center_ai_x + viewport_half_width;
-            float viewport_top = center_ai_y - viewport_half_height;
-            float viewport_bottom = center_ai_y + viewport_half_height;
-
-            bool outside_viewport = (ai_x < viewport_left || ai_x > viewport_right ||
-                                    ai_y < viewport_top || ai_y > viewport_bottom);
-
-            if (!outside_viewport) continue;
-
-            // Calculate angle
-            float angle = atan2(dy, dx);
-
-            // Calculate intersection point with viewport edge
-            float edge_x, edge_y;
-
-            // Determine which edge to place arrow on
-            // Calculate intersections with all edges
-            float t_left = (viewport_left - center_ai_x) / (dx != 0 ? dx : 0.0001f);
-            float t_right = (viewport_right - center_ai_x) / (dx != 0 ? dx : 0.0001f);
-            float t_top = (viewport_top - center_ai_y) / (dy != 0 ? dy : 0.0001f);
-            float t_bottom = (viewport_bottom - center_ai_y) / (dy != 0 ? dy : 0.0001f);
-
-            // Find the valid intersection (t between 0 and 1, and within edge bounds)
-            float t = 1.0f;
-            if (t_left > 0 && t_left < t) {
-                float y_intersect = center_ai_y + dy * t_left;
-                if (y_intersect >= viewport_top && y_intersect <= viewport_bottom) {
-                    t = t_left;
-                    edge_x = viewport_left;
-                    edge_y = y_intersect;
-                }
-            }
-            if (t_right > 0 && t_right < t) {
-                float y_intersect = center_ai_y + dy * t_right;
-                if (y_intersect >= viewport_top && y_intersect <= viewport_bottom) {
-                    t = t_right;
-                    edge_x = viewport_right;
-                    edge_y = y_intersect;
-                }
-            }
-            if (t_top > 0 && t_top < t) {
-                float x_intersect = center_ai_x + dx * t_top;
-                if (x_intersect >= viewport_left && x_intersect <= viewport_right) {
-                    t = t_top;
-                    edge_x = x_intersect;
-                    edge_y = viewport_top;
-                }
-            }
-            if (t_bottom > 0 && t_bottom < t) {
-                float x_intersect = center_ai_x + dx * t_bottom;
-                if (x_intersect >= viewport_left && x_intersect <= viewport_right) {
-                    t = t_bottom;
-                    edge_x = x_intersect;
-                    edge_y = viewport_bottom;
-                }
-            }
-
-            // Clamp arrow position to viewport edges with margin
-            edge_x = std::max(viewport_left + edge_margin, std::min(viewport_right - edge_margin, edge_x));
-            edge_y = std::max(viewport_top + edge_margin, std::min(viewport_bottom - edge_margin, edge_y));
-
-            // Draw arrow pointing in the direction
-            // Arrow is a triangle pointing outward
-            float cos_a = cos(angle);
-            float sin_a = sin(angle);
-
-            // Arrow tip (pointing outward)
-            float tip_x = edge_x + cos_a * arrow_size;
-            float tip_y = edge_y + sin_a * arrow_size;
-
-            // Arrow base (two points forming the base)
-            float perp_x = -sin_a;
-            float perp_y = cos_a;
-            float base_half_width = arrow_size * 0.5f;
-
-            float base1_x = edge_x + perp_x * base_half_width;
-            float base1_y = edge_y + perp_y * base_half_width;
-            float base2_x = edge_x - perp_x * base_half_width;
-            float base2_y = edge_y - perp_y * base_half_width;
-
-            // Draw arrow triangle
-            float arrow_vertices[] = {
-                tip_x, tip_y,
-                base1_x, base1_y,
-                base2_x, base2_y
-            };
-
-            GLuint arrow_vbo;
-            glGenBuffers(1, &arrow_vbo);
-            glBindBuffer(GL_ARRAY_BUFFER, arrow_vbo);
-            glBufferData(GL_ARRAY_BUFFER, sizeof(arrow_vertices), arrow_vertices, GL_STATIC_DRAW);
-
-            GLint pos_attr = glGetAttribLocation(state.shader_program, "a_position");
-            glEnableVertexAttribArray(pos_attr);
-            glVertexAttribPointer(pos_attr, 2, GL_FLOAT, GL_FALSE, 0, 0);
-
-            // Use team color for arrow
-            if (team >= 0 && team < 4) {
-                glUniform3f(color_loc, g_team_colors[team][0], g_team_colors[team][1], g_team_colors[team][2]);
-            } else {
-                glUniform3f(color_loc, 0.8f, 0.8f, 0.9f); // Default light gray
-            }
-
-            glUniform2f(offset_loc, offset_x, offset_y);
-            glDrawArrays(GL_TRIANGLES, 0, 3);
-
-            glDeleteBuffers(1, &arrow_vbo);
-        }
-    }
 }
@@ -1,15 +1,33 @@
 #ifndef RENDERER_H
 #define RENDERER_H
 
+#include <stdint.h>
+
+enum GridMode {
+    GRID_MODE_LINES = 0,      // one streamed line per grid row and column
+    GRID_MODE_PROCEDURAL = 1  // one full-screen triangle, lines computed per pixel
+};
+
+struct ViewCull; // culling.h
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 void init_renderer(int canvas_width, int canvas_height, int context_index);
 void resize_renderer(int canvas_width, int canvas_height);
+void set_grid_mode(int mode);
+// Size in pixels of one viewport, i.e. the visible world area around a camera
+int get_viewport_width();
+int get_viewport_height();
+// Render all viewports through context 0 into the quadrants of one canvas
+// (twice the viewport size); resize_renderer still takes the viewport size.
+void set_shared_context(int enabled);
 void render_frame(float player_x, float player_y, float grid_size);
+// Draws the view's visible entities as squares and its off-screen entities
+// as edge arrows, so the cost follows what the camera sees
 void render_frame_for_viewport(float center_ai_x, float center_ai_y, float grid_size, int viewport_index,
-                              float ai_positions[4][2], int ai_teams[4]);
+                              const struct ViewCull* view);
 
 #ifdef __cplusplus
 }
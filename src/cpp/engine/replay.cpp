@@ -0,0 +1,237 @@
+#include "replay.h"
+#include "movement.h"
+#include "flow_field.h"
+#include <cmath>
+#include <cstring>
+
+#define REPLAY_HEADER_BYTES 20        // magic, version, world bounds, velocity range, keyframe interval
+#define REPLAY_KEYFRAME_HEADER_BYTES 12
+#define REPLAY_TICK_HEADER_BYTES 16
+#define REPLAY_DECISION_BYTES 12      // id, then x, y, vx, vy as int16
+#define REPLAY_QUANT_MAX 32767.0f
+
+// Little-endian fields at arbitrary offsets, like the world file
+static void put_u32(std::vector<uint8_t>& bytes, uint32_t value) {
+    uint8_t raw[4];
+    memcpy(raw, &value, 4);
+    bytes.insert(bytes.end(), raw, raw + 4);
+}
+
+static void put_f32(std::vector<uint8_t>& bytes, float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, 4);
+    put_u32(bytes, bits);
+}
+
+static void put_i16(std::vector<uint8_t>& bytes, int16_t value) {
+    uint8_t raw[2];
+    memcpy(raw, &value, 2);
+    bytes.insert(bytes.end(), raw, raw + 2);
+}
+
+static uint32_t get_u32(const uint8_t* at) {
+    uint32_t value;
+    memcpy(&value, at, 4);
+    return value;
+}
+
+static float get_f32(const uint8_t* at) {
+    float value;
+    memcpy(&value, at, 4);
+    return value;
+}
+
+static int16_t get_i16(const uint8_t* at) {
+    int16_t value;
+    memcpy(&value, at, 2);
+    return value;
+}
+
+static int16_t quantise(float value, float range) {
+    float scaled = value / range * REPLAY_QUANT_MAX;
+    if (scaled > REPLAY_QUANT_MAX) scaled = REPLAY_QUANT_MAX;
+    if (scaled < -REPLAY_QUANT_MAX) scaled = -REPLAY_QUANT_MAX;
+    return (int16_t)lrintf(scaled);
+}
+
+static float dequantise(int16_t value, float range) {
+    return (float)value * (range / REPLAY_QUANT_MAX);
+}
+
+void replay_recorder_begin(ReplayRecorder& recorder, float world_bounds, float velocity_range,
+                           int keyframe_interval) {
+    recorder.bytes.clear();
+    recorder.keyframes.clear();
+    recorder.world_bounds = world_bounds;
+    recorder.velocity_range = velocity_range;
+    recorder.keyframe_interval = keyframe_interval > 0 ? (uint32_t)keyframe_interval : 1;
+    recorder.decisions = 0;
+    recorder.tick_record = 0;
+    recorder.tick_decisions = 0;
+
+    put_u32(recorder.bytes, REPLAY_MAGIC);
+    put_u32(recorder.bytes, REPLAY_VERSION);
+    put_f32(recorder.bytes, world_bounds);
+    put_f32(recorder.bytes, velocity_range);
+    put_u32(recorder.bytes, recorder.keyframe_interval);
+}
+
+bool replay_recorder_keyframe_due(const ReplayRecorder& recorder, uint32_t tick) {
+    return recorder.keyframes.empty() || tick - recorder.keyframes.back().tick >= recorder.keyframe_interval;
+}
+
+void replay_recorder_add_keyframe(ReplayRecorder& recorder, uint32_t tick, const WorldFileHeader& header,
+                                  const void* block) {
+    size_t size = (size_t)header.block_offset + (size_t)header.block_size;
+    ReplayKeyframe keyframe = {tick, recorder.bytes.size()};
+    recorder.keyframes.push_back(keyframe);
+
+    put_u32(recorder.bytes, REPLAY_RECORD_KEYFRAME);
+    put_u32(recorder.bytes, tick);
+    put_u32(recorder.bytes, (uint32_t)size);
+    size_t at = recorder.bytes.size();
+    recorder.bytes.resize(at + size);
+    world_file_serialize(header, block, recorder.bytes.data() + at);
+}
+
+void replay_recorder_begin_tick(ReplayRecorder& recorder, uint32_t tick, float delta_time) {
+    recorder.tick_record = recorder.bytes.size();
+    recorder.tick_decisions = 0;
+    put_u32(recorder.bytes, REPLAY_RECORD_TICK);
+    put_u32(recorder.bytes, tick);
+    put_f32(recorder.bytes, delta_time);
+    put_u32(recorder.bytes, 0); // decision count, patched by end_tick
+}
+
+void replay_recorder_add_decision(ReplayRecorder& recorder, uint32_t id, float x, float y, float vx, float vy) {
+    put_u32(recorder.bytes, id);
+    put_i16(recorder.bytes, quantise(x, recorder.world_bounds));
+    put_i16(recorder.bytes, quantise(y, recorder.world_bounds));
+    put_i16(recorder.bytes, quantise(vx, recorder.velocity_range));
+    put_i16(recorder.bytes, quantise(vy, recorder.velocity_range));
+    recorder.tick_decisions++;
+}
+
+void replay_recorder_end_tick(ReplayRecorder& recorder) {
+    memcpy(recorder.bytes.data() + recorder.tick_record + 12, &recorder.tick_decisions, 4);
+    recorder.decisions += recorder.tick_decisions;
+}
+
+bool replay_open(Replay& replay, const void* data, size_t size) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    replay.data = bytes;
+    replay.size = size;
+    replay.keyframes.clear();
+
+    if (size < REPLAY_HEADER_BYTES || get_u32(bytes) != REPLAY_MAGIC || get_u32(bytes + 4) != REPLAY_VERSION) {
+        return false;
+    }
+    replay.world_bounds = get_f32(bytes + 8);
+    replay.velocity_range = get_f32(bytes + 12);
+    if (!(replay.world_bounds > 0.0f) || !(replay.velocity_range > 0.0f)) return false;
+
+    // Records must start with a keyframe and then follow each other tick by tick
+    size_t at = REPLAY_HEADER_BYTES;
+    uint32_t tick = 0;
+    while (at < size) {
+        if (size - at < 8) return false;
+        uint32_t type = get_u32(bytes + at);
+        uint32_t record_tick = get_u32(bytes + at + 4);
+
+        if (type == REPLAY_RECORD_KEYFRAME) {
+            if (size - at < REPLAY_KEYFRAME_HEADER_BYTES) return false;
+            if (!replay.keyframes.empty() && record_tick != tick) return false;
+            size_t world_size = get_u32(bytes + at + 8);
+            if (world_size < sizeof(WorldFileHeader) || size - at - REPLAY_KEYFRAME_HEADER_BYTES < world_size) {
+                return false;
+            }
+
+            // Only the header is read, so an unaligned copy of it validates fine
+            WorldFileHeader header;
+            memcpy(&header, bytes + at + REPLAY_KEYFRAME_HEADER_BYTES, sizeof(header));
+            if (!world_file_validate(&header, world_size)) return false;
+
+            ReplayKeyframe keyframe = {record_tick, at};
+            replay.keyframes.push_back(keyframe);
+            at += REPLAY_KEYFRAME_HEADER_BYTES + world_size;
+        } else if (type == REPLAY_RECORD_TICK) {
+            if (replay.keyframes.empty() || record_tick != tick + 1) return false;
+            if (size - at < REPLAY_TICK_HEADER_BYTES) return false;
+            size_t count = get_u32(bytes + at + 12);
+            if ((size - at - REPLAY_TICK_HEADER_BYTES) / REPLAY_DECISION_BYTES < count) return false;
+            at += REPLAY_TICK_HEADER_BYTES + count * REPLAY_DECISION_BYTES;
+        } else {
+            return false;
+        }
+        tick = record_tick;
+    }
+
+    if (replay.keyframes.empty()) return false;
+    replay.first_tick = replay.keyframes.front().tick;
+    replay.last_tick = tick;
+    return true;
+}
+
+bool replay_seek(const Replay& replay, uint32_t tick, ReplayState& state) {
+    if (replay.keyframes.empty() || tick < replay.first_tick || tick > replay.last_tick) return false;
+
+    // Last keyframe at or before the tick
+    size_t k = replay.keyframes.size() - 1;
+    while (replay.keyframes[k].tick > tick) k--;
+    const uint8_t* record = replay.data + replay.keyframes[k].offset;
+
+    WorldFileHeader header;
+    memcpy(&header, record + REPLAY_KEYFRAME_HEADER_BYTES, sizeof(header));
+    EntityStore& entities = state.entities;
+    if (!entities.block || entities.capacity != header.capacity) {
+        entity_store_free(entities);
+        if (!entity_store_init(entities, header.capacity)) return false;
+    }
+    memcpy(entities.block, record + REPLAY_KEYFRAME_HEADER_BYTES + header.block_offset, (size_t)header.block_size);
+    entities.count = header.count;
+    entities.free_id_count = header.free_id_count;
+    state.tick = replay.keyframes[k].tick;
+
+    // Decisions are applied through id_to_index, so a keyframe has to pass
+    // the same checks as a world snapshot (world_attach)
+    bool valid = entity_store_ids_consistent(entities);
+    for (int i = 0; valid && i < entities.count; i++) {
+        valid = entities.team[i] >= 0 && entities.team[i] < FLOW_MAX_TEAMS;
+    }
+    if (!valid) {
+        entity_store_clear(entities);
+        return false;
+    }
+
+    // Straight-line motion up to each step's decisions, which resync the
+    // entities that made them
+    size_t at = replay.keyframes[k].offset + REPLAY_KEYFRAME_HEADER_BYTES + get_u32(record + 8);
+    while (state.tick < tick) {
+        const uint8_t* tick_record = replay.data + at;
+        if (get_u32(tick_record) != REPLAY_RECORD_TICK) return false;
+
+        float delta_time = get_f32(tick_record + 8);
+        uint32_t count = get_u32(tick_record + 12);
+        integrate_and_bounce(entities.x, entities.y, entities.vx, entities.vy, entities.count, delta_time,
+                             header.world_bounds);
+
+        const uint8_t* decision = tick_record + REPLAY_TICK_HEADER_BYTES;
+        for (uint32_t d = 0; d < count; d++, decision += REPLAY_DECISION_BYTES) {
+            int index = entity_store_index_of(entities, get_u32(decision));
+            if (index < 0) continue;
+            entities.x[index] = dequantise(get_i16(decision + 4), replay.world_bounds);
+            entities.y[index] = dequantise(get_i16(decision + 6), replay.world_bounds);
+            entities.vx[index] = dequantise(get_i16(decision + 8), replay.velocity_range);
+            entities.vy[index] = dequantise(get_i16(decision + 10), replay.velocity_range);
+        }
+
+        at += REPLAY_TICK_HEADER_BYTES + (size_t)count * REPLAY_DECISION_BYTES;
+        state.tick = get_u32(tick_record + 4);
+    }
+    return true;
+}
+
+void replay_state_free(ReplayState& state) {
+    entity_store_free(state.entities);
+    state.tick = 0;
+}
@@ -0,0 +1,82 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "entity_store.h"
+#include "world_file.h"
+#include <cstdint>
+#include <vector>
+
+// Replay stream: a header, then records in tick order. A keyframe record is a
+// whole world snapshot (world_file.h) taken after `tick` steps. A tick record
+// lists the entities whose direction changed in step `tick` (a scheduled
+// re-roll, a bounce off the world edge, a collision push, steering or goal seeking), with
+// their position and velocity after the step quantised to 16 bits. Everything else
+// moves in a straight line between decisions, so a replayer rebuilds any tick
+// from the nearest keyframe before it by integrating and applying the
+// decisions on the way. Storage grows with the number of decisions plus the
+// keyframes, not with entities x ticks. Replayed positions are within the
+// quantisation error of the recorded run, and exact at keyframes.
+
+#define REPLAY_MAGIC 0x524D4953u // "SIMR"
+#define REPLAY_VERSION 1
+
+enum ReplayRecordType {
+    REPLAY_RECORD_KEYFRAME = 1, // tick, byte size, world file bytes
+    REPLAY_RECORD_TICK = 2      // tick, delta time, decision count, decisions
+};
+
+struct ReplayKeyframe {
+    uint32_t tick;
+    size_t offset; // of the record in the stream
+};
+
+struct ReplayRecorder {
+    std::vector<uint8_t> bytes;
+    std::vector<ReplayKeyframe> keyframes;
+    float world_bounds;    // positions are quantised over [-world_bounds, world_bounds]
+    float velocity_range;  // velocities over [-velocity_range, velocity_range]
+    uint32_t keyframe_interval;
+    long long decisions;   // recorded so far
+    size_t tick_record;    // offset of the open tick record
+    uint32_t tick_decisions;
+};
+
+void replay_recorder_begin(ReplayRecorder& recorder, float world_bounds, float velocity_range,
+                           int keyframe_interval);
+// True once keyframe_interval ticks have passed since the last keyframe
+bool replay_recorder_keyframe_due(const ReplayRecorder& recorder, uint32_t tick);
+void replay_recorder_add_keyframe(ReplayRecorder& recorder, uint32_t tick, const WorldFileHeader& header,
+                                  const void* block);
+// A tick record is opened, filled with the step's decisions and closed
+void replay_recorder_begin_tick(ReplayRecorder& recorder, uint32_t tick, float delta_time);
+void replay_recorder_add_decision(ReplayRecorder& recorder, uint32_t id, float x, float y, float vx, float vy);
+void replay_recorder_end_tick(ReplayRecorder& recorder);
+
+// A recorded stream indexed for seeking. data must outlive the replay.
+struct Replay {
+    const uint8_t* data;
+    size_t size;
+    float world_bounds;
+    float velocity_range;
+    uint32_t first_tick; // of the first keyframe
+    uint32_t last_tick;  // last tick that can be reconstructed
+    std::vector<ReplayKeyframe> keyframes;
+};
+
+// Validates the header and every record; false on a malformed stream
+bool replay_open(Replay& replay, const void* data, size_t size);
+
+// World rebuilt at one tick. Only positions, velocities, teams and ids are
+// replayed; decision ticks and counters are as of the keyframe.
+struct ReplayState {
+    EntityStore entities;
+    uint32_t tick;
+};
+
+// Loads the last keyframe at or before tick and replays up to tick.
+// False when tick is outside [first_tick, last_tick] or the keyframe's id
+// tables or teams are inconsistent, which leaves the state empty.
+bool replay_seek(const Replay& replay, uint32_t tick, ReplayState& state);
+void replay_state_free(ReplayState& state);
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef RNG_H
+#define RNG_H
+
+#include <cstdint>
+
+// Stateless counter-based random numbers (Philox4x32-10, Salmon et al. 2011).
+// Each call hashes (seed, entity id) as the key and (counter, stream) as the
+// counter, so an entity's n-th decision draws the same values no matter which
+// thread, SIMD lane or update order produces it. There is no shared state.
+
+// Streams keep independent uses of the same entity key from overlapping
+enum RngStream {
+    RNG_STREAM_DECISION = 0, // direction, speed and timer re-rolls
+    RNG_STREAM_SPAWN = 1     // initial placement
+};
+
+static inline void rng_philox4x32(uint32_t counter0, uint32_t counter1, uint32_t seed, uint32_t entity_id,
+                                  uint32_t out[4]) {
+    const uint32_t M0 = 0xD2511F53u, M1 = 0xCD9E8D57u;
+    const uint32_t W0 = 0x9E3779B9u, W1 = 0xBB67AE85u;
+
+    uint32_t c0 = counter0, c1 = counter1, c2 = 0, c3 = 0;
+    uint32_t k0 = seed, k1 = entity_id;
+
+    for (int round = 0; round < 10; round++) {
+        uint64_t p0 = (uint64_t)M0 * c0;
+        uint64_t p1 = (uint64_t)M1 * c2;
+        uint32_t n0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c1 = (uint32_t)p1;
+        c3 = (uint32_t)p0;
+        c0 = n0;
+        c2 = n2;
+        k0 += W0;
+        k1 += W1;
+    }
+
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+// Maps the top 24 bits to a float in [0, 1)
+static inline float rng_to_unit_float(uint32_t bits) {
+    return (float)(bits >> 8) * (1.0f / 16777216.0f);
+}
+
+// Four uniform floats in [0, 1) for one (seed, entity, counter, stream) tuple
+static inline void rng_uniform4(uint32_t seed, uint32_t entity_id, uint32_t counter, uint32_t stream,
+                                float out[4]) {
+    uint32_t bits[4];
+    rng_philox4x32(counter, stream, seed, entity_id, bits);
+    for (int k = 0; k < 4; k++) {
+        out[k] = rng_to_unit_float(bits[k]);
+    }
+}
+
+// Batch form for a lane of entities: fills out[k * n + i] with the k-th
+// uniform float of entity ids[i] at counters[i], for k in 0..3. The loop has
+// no cross-lane dependency so the compiler can vectorize it.
+static inline void rng_uniform4_lanes(uint32_t seed, const uint32_t* ids, const uint32_t* counters, int n,
+                                      uint32_t stream, float* out) {
+    for (int i = 0; i < n; i++) {
+        uint32_t bits[4];
+        rng_philox4x32(counters[i], stream, seed, ids[i], bits);
+        out[i] = rng_to_unit_float(bits[0]);
+        out[n + i] = rng_to_unit_float(bits[1]);
+        out[2 * n + i] = rng_to_unit_float(bits[2]);
+        out[3 * n + i] = rng_to_unit_float(bits[3]);
+    }
+}
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+// Thin wrapper over the float vector types available to each build:
+// WebAssembly SIMD128 for emcc (-msimd128), AVX2 or SSE2 for native builds,
+// and a one-lane scalar fallback. Kernels written against these helpers
+// compile to the widest instruction set enabled at build time.
+//
+// Only lane-exact operations are exposed (no fused multiply-add, no
+// approximate reciprocals), so every path rounds exactly like scalar code.
+
+#if defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+
+#define SIMD_WIDTH 4
+#define SIMD_NAME "wasm-simd128"
+typedef v128_t simd_f32;
+
+static inline simd_f32 simd_load(const float* p) { return wasm_v128_load(p); }
+static inline void simd_store(float* p, simd_f32 v) { wasm_v128_store(p, v); }
+static inline simd_f32 simd_splat(float f) { return wasm_f32x4_splat(f); }
+static inline simd_f32 simd_add(simd_f32 a, simd_f32 b) { return wasm_f32x4_add(a, b); }
+static inline simd_f32 simd_sub(simd_f32 a, simd_f32 b) { return wasm_f32x4_sub(a, b); }
+static inline simd_f32 simd_mul(simd_f32 a, simd_f32 b) { return wasm_f32x4_mul(a, b); }
+static inline simd_f32 simd_div(simd_f32 a, simd_f32 b) { return wasm_f32x4_div(a, b); }
+static inline simd_f32 simd_sqrt(simd_f32 a) { return wasm_f32x4_sqrt(a); }
+static inline simd_f32 simd_min(simd_f32 a, simd_f32 b) { return wasm_f32x4_pmin(a, b); }
+static inline simd_f32 simd_max(simd_f32 a, simd_f32 b) { return wasm_f32x4_pmax(a, b); }
+static inline simd_f32 simd_cmplt(simd_f32 a, simd_f32 b) { return wasm_f32x4_lt(a, b); }
+static inline simd_f32 simd_cmpgt(simd_f32 a, simd_f32 b) { return wasm_f32x4_gt(a, b); }
+static inline simd_f32 simd_cmpeq(simd_f32 a, simd_f32 b) { return wasm_f32x4_eq(a, b); }
+static inline simd_f32 simd_or(simd_f32 a, simd_f32 b) { return wasm_v128_or(a, b); }
+static inline simd_f32 simd_and(simd_f32 a, simd_f32 b) { return wasm_v128_and(a, b); }
+static inline simd_f32 simd_xor(simd_f32 a, simd_f32 b) { return wasm_v128_xor(a, b); }
+static inline bool simd_any(simd_f32 mask) { return wasm_v128_any_true(mask); }
+// Bit l set for each set lane l of a mask
+static inline unsigned simd_movemask(simd_f32 mask) { return wasm_i32x4_bitmask(mask); }
+// mask ? a : b
+static inline simd_f32 simd_select(simd_f32 mask, simd_f32 a, simd_f32 b) { return wasm_v128_bitselect(a, b, mask); }
+
+#elif defined(__AVX2__)
+#include <immintrin.h>
+
+#define SIMD_WIDTH 8
+#define SIMD_NAME "avx2"
+typedef __m256 simd_f32;
+
+static inline simd_f32 simd_load(const float* p) { return _mm256_loadu_ps(p); }
+static inline void simd_store(float* p, simd_f32 v) { _mm256_storeu_ps(p, v); }
+static inline simd_f32 simd_splat(float f) { return _mm256_set1_ps(f); }
+static inline simd_f32 simd_add(simd_f32 a, simd_f32 b) { return _mm256_add_ps(a, b); }
+static inline simd_f32 simd_sub(simd_f32 a, simd_f32 b) { return _mm256_sub_ps(a, b); }
+static inline simd_f32 simd_mul(simd_f32 a, simd_f32 b) { return _mm256_mul_ps(a, b); }
+static inline simd_f32 simd_div(simd_f32 a, simd_f32 b) { return _mm256_div_ps(a, b); }
+static inline simd_f32 simd_sqrt(simd_f32 a) { return _mm256_sqrt_ps(a); }
+static inline simd_f32 simd_min(simd_f32 a, simd_f32 b) { return _mm256_min_ps(a, b); }
+static inline simd_f32 simd_max(simd_f32 a, simd_f32 b) { return _mm256_max_ps(a, b); }
+static inline simd_f32 simd_cmplt(simd_f32 a, simd_f32 b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+static inline simd_f32 simd_cmpgt(simd_f32 a, simd_f32 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+static inline simd_f32 simd_cmpeq(simd_f32 a, simd_f32 b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+static inline simd_f32 simd_or(simd_f32 a, simd_f32 b) { return _mm256_or_ps(a, b); }
+static inline simd_f32 simd_and(simd_f32 a, simd_f32 b) { return _mm256_and_ps(a, b); }
+static inline simd_f32 simd_xor(simd_f32 a, simd_f32 b) { return _mm256_xor_ps(a, b); }
+static inline bool simd_any(simd_f32 mask) { return _mm256_movemask_ps(mask) != 0; }
+static inline unsigned simd_movemask(simd_f32 mask) { return (unsigned)_mm256_movemask_ps(mask); }
+static inline simd_f32 simd_select(simd_f32 mask, simd_f32 a, simd_f32 b) { return _mm256_blendv_ps(b, a, mask); }
+
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+
+#define SIMD_WIDTH 4
+#define SIMD_NAME "sse2"
+typedef __m128 simd_f32;
+
+static inline simd_f32 simd_load(const float* p) { return _mm_loadu_ps(p); }
+static inline void simd_store(float* p, simd_f32 v) { _mm_storeu_ps(p, v); }
+static inline simd_f32 simd_splat(float f) { return _mm_set1_ps(f); }
+static inline simd_f32 simd_add(simd_f32 a, simd_f32 b) { return _mm_add_ps(a, b); }
+static inline simd_f32 simd_sub(simd_f32 a, simd_f32 b) { return _mm_sub_ps(a, b); }
+static inline simd_f32 simd_mul(simd_f32 a, simd_f32 b) { return _mm_mul_ps(a, b); }
+static inline simd_f32 simd_div(simd_f32 a, simd_f32 b) { return _mm_div_ps(a, b); }
+static inline simd_f32 simd_sqrt(simd_f32 a) { return _mm_sqrt_ps(a); }
+static inline simd_f32 simd_min(simd_f32 a, simd_f32 b) { return _mm_min_ps(a, b); }
+static inline simd_f32 simd_max(simd_f32 a, simd_f32 b) { return _mm_max_ps(a, b); }
+static inline simd_f32 simd_cmplt(simd_f32 a, simd_f32 b) { return _mm_cmplt_ps(a, b); }
+static inline simd_f32 simd_cmpgt(simd_f32 a, simd_f32 b) { return _mm_cmpgt_ps(a, b); }
+static inline simd_f32 simd_cmpeq(simd_f32 a, simd_f32 b) { return _mm_cmpeq_ps(a, b); }
+static inline simd_f32 simd_or(simd_f32 a, simd_f32 b) { return _mm_or_ps(a, b); }
+static inline simd_f32 simd_and(simd_f32 a, simd_f32 b) { return _mm_and_ps(a, b); }
+static inline simd_f32 simd_xor(simd_f32 a, simd_f32 b) { return _mm_xor_ps(a, b); }
+static inline bool simd_any(simd_f32 mask) { return _mm_movemask_ps(mask) != 0; }
+static inline unsigned simd_movemask(simd_f32 mask) { return (unsigned)_mm_movemask_ps(mask); }
+static inline simd_f32 simd_select(simd_f32 mask, simd_f32 a, simd_f32 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+#else
+#include <cmath>
+#include <cstring>
+
+#define SIMD_WIDTH 1
+#define SIMD_NAME "scalar"
+typedef float simd_f32;
+
+static inline unsigned simd_bits(float f) { unsigned u; memcpy(&u, &f, 4); return u; }
+static inline float simd_from_bits(unsigned u) { float f; memcpy(&f, &u, 4); return f; }
+static inline float simd_mask(bool b) { return simd_from_bits(b ? 0xffffffffu : 0u); }
+
+static inline simd_f32 simd_load(const float* p) { return *p; }
+static inline void simd_store(float* p, simd_f32 v) { *p = v; }
+static inline simd_f32 simd_splat(float f) { return f; }
+static inline simd_f32 simd_add(simd_f32 a, simd_f32 b) { return a + b; }
+static inline simd_f32 simd_sub(simd_f32 a, simd_f32 b) { return a - b; }
+static inline simd_f32 simd_mul(simd_f32 a, simd_f32 b) { return a * b; }
+static inline simd_f32 simd_div(simd_f32 a, simd_f32 b) { return a / b; }
+static inline simd_f32 simd_sqrt(simd_f32 a) { return sqrtf(a); }
+static inline simd_f32 simd_min(simd_f32 a, simd_f32 b) { return a < b ? a : b; }
+static inline simd_f32 simd_max(simd_f32 a, simd_f32 b) { return a > b ? a : b; }
+static inline simd_f32 simd_cmplt(simd_f32 a, simd_f32 b) { return simd_mask(a < b); }
+static inline simd_f32 simd_cmpgt(simd_f32 a, simd_f32 b) { return simd_mask(a > b); }
+static inline simd_f32 simd_cmpeq(simd_f32 a, simd_f32 b) { return simd_mask(a == b); }
+static inline simd_f32 simd_or(simd_f32 a, simd_f32 b) { return simd_from_bits(simd_bits(a) | simd_bits(b)); }
+static inline simd_f32 simd_and(simd_f32 a, simd_f32 b) { return simd_from_bits(simd_bits(a) & simd_bits(b)); }
+static inline simd_f32 simd_xor(simd_f32 a, simd_f32 b) { return simd_from_bits(simd_bits(a) ^ simd_bits(b)); }
+static inline bool simd_any(simd_f32 mask) { return simd_bits(mask) != 0; }
+static inline unsigned simd_movemask(simd_f32 mask) { return simd_bits(mask) & 1u; }
+static inline simd_f32 simd_select(simd_f32 mask, simd_f32 a, simd_f32 b) { return simd_bits(mask) ? a : b; }
+
+#endif
+
+#endif
@@ -0,0 +1,148 @@
+#include "spatial_grid.h"
+#include <cmath>
+#include <cstring>
+
+void spatial_grid_init(SpatialGrid& grid, float world_bounds, float cell_size) {
+    if (cell_size <= 0.0f) cell_size = 50.0f;
+
+    grid.origin = -world_bounds;
+    grid.cell_size = cell_size;
+    grid.inv_cell_size = 1.0f / cell_size;
+    grid.cells_per_side = (int)ceilf(2.0f * world_bounds / cell_size);
+    if (grid.cells_per_side < 1) grid.cells_per_side = 1;
+    grid.entity_count = 0;
+    grid.valid = false;
+
+    grid.cell_start.assign((size_t)grid.cells_per_side * grid.cells_per_side + 1, 0);
+    grid.cell_entities.clear();
+    grid.entity_cell.clear();
+    grid.next_cell.clear();
+}
+
+int spatial_grid_cell_of(const SpatialGrid& grid, float x, float y) {
+    return spatial_grid_axis_cell(grid, y) * grid.cells_per_side + spatial_grid_axis_cell(grid, x);
+}
+
+void spatial_grid_copy(SpatialGrid& dst, const SpatialGrid& src) {
+    dst.origin = src.origin;
+    dst.cell_size = src.cell_size;
+    dst.inv_cell_size = src.inv_cell_size;
+    dst.cells_per_side = src.cells_per_side;
+    dst.entity_count = src.entity_count;
+    dst.valid = src.valid;
+    dst.cell_start.assign(src.cell_start.begin(), src.cell_start.end());
+    dst.cell_entities.assign(src.cell_entities.begin(), src.cell_entities.end());
+}
+
+void spatial_grid_begin_rebuild(SpatialGrid& grid, int count) {
+    grid.next_cell.resize(count);
+}
+
+void spatial_grid_assign_cells(SpatialGrid& grid, const float* x, const float* y, int begin, int end) {
+    int32_t* next_cell = grid.next_cell.data();
+    for (int i = begin; i < end; i++) {
+        next_cell[i] = spatial_grid_cell_of(grid, x[i], y[i]);
+    }
+}
+
+void spatial_grid_rebuild(SpatialGrid& grid) {
+    int count = (int)grid.next_cell.size();
+
+    // Incremental: nothing to do if every entity stayed in its cell
+    if (grid.valid && count == grid.entity_count &&
+        memcmp(grid.next_cell.data(), grid.entity_cell.data(), count * sizeof(int32_t)) == 0) {
+        return;
+    }
+
+    grid.entity_cell.swap(grid.next_cell);
+    grid.entity_count = count;
+    grid.valid = true;
+
+    // Counting sort: histogram, exclusive prefix sum, then a stable scatter
+    int num_cells = grid.cells_per_side * grid.cells_per_side;
+    int32_t* cell_start = grid.cell_start.data();
+    const int32_t* entity_cell = grid.entity_cell.data();
+    memset(cell_start, 0, (num_cells + 1) * sizeof(int32_t));
+
+    for (int i = 0; i < count; i++) {
+        cell_start[entity_cell[i] + 1]++;
+    }
+    for (int c = 0; c < num_cells; c++) {
+        cell_start[c + 1] += cell_start[c];
+    }
+
+    grid.cell_entities.resize(count);
+    int32_t* cell_entities = grid.cell_entities.data();
+
+    // Use the (now stale) pending buffer as the per-cell write cursor
+    grid.next_cell.assign(cell_start, cell_start + num_cells);
+    int32_t* cursor = grid.next_cell.data();
+    for (int i = 0; i < count; i++) {
+        cell_entities[cursor[entity_cell[i]]++] = i;
+    }
+    grid.next_cell.resize(count);
+}
+
+void spatial_grid_build(SpatialGrid& grid, const float* x, const float* y, int count) {
+    spatial_grid_begin_rebuild(grid, count);
+    spatial_grid_assign_cells(grid, x, y, 0, count);
+    spatial_grid_rebuild(grid);
+}
+
+int spatial_grid_query_aabb(const SpatialGrid& grid, const float* x, const float* y,
+                            float min_x, float min_y, float max_x, float max_y,
+                            int32_t* out, int max_out) {
+    if (!grid.valid || max_out <= 0) return 0;
+
+    int cell_min_x = spatial_grid_axis_cell(grid, min_x), cell_max_x = spatial_grid_axis_cell(grid, max_x);
+    int cell_min_y = spatial_grid_axis_cell(grid, min_y), cell_max_y = spatial_grid_axis_cell(grid, max_y);
+    const int32_t* cell_start = grid.cell_start.data();
+    const int32_t* cell_entities = grid.cell_entities.data();
+
+    int found = 0;
+    for (int cy = cell_min_y; cy <= cell_max_y; cy++) {
+        for (int cx = cell_min_x; cx <= cell_max_x; cx++) {
+            int cell = cy * grid.cells_per_side + cx;
+            bool interior = cx > cell_min_x && cx < cell_max_x && cy > cell_min_y && cy < cell_max_y;
+
+            for (int k = cell_start[cell]; k < cell_start[cell + 1]; k++) {
+                int i = cell_entities[k];
+                // Cells strictly inside the box need no per-entity test
+                if (interior || (x[i] >= min_x && x[i] <= max_x && y[i] >= min_y && y[i] <= max_y)) {
+                    out[found++] = i;
+                    if (found == max_out) return found;
+                }
+            }
+        }
+    }
+    return found;
+}
+
+int spatial_grid_query_radius(const SpatialGrid& grid, const float* x, const float* y,
+                              float center_x, float center_y, float radius,
+                              int32_t* out, int max_out) {
+    if (!grid.valid || max_out <= 0) return 0;
+
+    int cell_min_x = spatial_grid_axis_cell(grid, center_x - radius), cell_max_x = spatial_grid_axis_cell(grid, center_x + radius);
+    int cell_min_y = spatial_grid_axis_cell(grid, center_y - radius), cell_max_y = spatial_grid_axis_cell(grid, center_y + radius);
+    const int32_t* cell_start = grid.cell_start.data();
+    const int32_t* cell_entities = grid.cell_entities.data();
+    float radius_sq = radius * radius;
+
+    int found = 0;
+    for (int cy = cell_min_y; cy <= cell_max_y; cy++) {
+        for (int cx = cell_min_x; cx <= cell_max_x; cx++) {
+            int cell = cy * grid.cells_per_side + cx;
+            for (int k = cell_start[cell]; k < cell_start[cell + 1]; k++) {
+                int i = cell_entities[k];
+                float dx = x[i] - center_x;
+                float dy = y[i] - center_y;
+                if (dx * dx + dy * dy <= radius_sq) {
+                    out[found++] = i;
+                    if (found == max_out) return found;
+                }
+            }
+        }
+    }
+    return found;
+}
@@ -0,0 +1,60 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+// Uniform grid over the square world [-bounds, bounds] for neighbour and
+// range queries. Entities are bucketed by the cell containing their position
+// and stored as one flat array grouped by cell (counting sort), with
+// cell_start[c]..cell_start[c + 1] giving the range of cell c. Entities are
+// referenced by dense store index.
+struct SpatialGrid {
+    float origin;        // world coordinate of the first cell edge (-bounds)
+    float cell_size;
+    float inv_cell_size;
+    int cells_per_side;
+    int entity_count;    // entities in the current cell arrays
+    bool valid;          // false until the first rebuild
+    std::vector<int32_t> cell_start;    // cells + 1 offsets into cell_entities
+    std::vector<int32_t> cell_entities; // entity indices grouped by cell
+    std::vector<int32_t> entity_cell;   // cell of each entity at the last rebuild
+    std::vector<int32_t> next_cell;     // cells assigned for the pending rebuild
+};
+
+void spatial_grid_init(SpatialGrid& grid, float world_bounds, float cell_size);
+
+// Rebuild in two phases so the per-entity part can run inside parallel
+// update chunks: size the grid for count entities, assign cells to any
+// disjoint ranges (thread-safe across ranges), then rebuild. The rebuild is
+// skipped when no entity changed cell since the last one.
+void spatial_grid_begin_rebuild(SpatialGrid& grid, int count);
+void spatial_grid_assign_cells(SpatialGrid& grid, const float* x, const float* y, int begin, int end);
+void spatial_grid_rebuild(SpatialGrid& grid);
+
+// Convenience wrapper running all three phases on one thread
+void spatial_grid_build(SpatialGrid& grid, const float* x, const float* y, int count);
+
+// Cell column (or row) of a coordinate, clamped into the grid
+static inline int spatial_grid_axis_cell(const SpatialGrid& grid, float v) {
+    int c = (int)floorf((v - grid.origin) * grid.inv_cell_size);
+    return c < 0 ? 0 : (c >= grid.cells_per_side ? grid.cells_per_side - 1 : c);
+}
+
+int spatial_grid_cell_of(const SpatialGrid& grid, float x, float y);
+
+// Copies what queries need (layout and cell arrays) but not the rebuild
+// state, e.g. to hand a read-only grid to another thread. Reuses dst's storage.
+void spatial_grid_copy(SpatialGrid& dst, const SpatialGrid& src);
+
+// Queries write up to max_out matching entity indices to out and return how
+// many were written. Both test entity positions (square centres).
+int spatial_grid_query_aabb(const SpatialGrid& grid, const float* x, const float* y,
+                            float min_x, float min_y, float max_x, float max_y,
+                            int32_t* out, int max_out);
+int spatial_grid_query_radius(const SpatialGrid& grid, const float* x, const float* y,
+                              float center_x, float center_y, float radius,
+                              int32_t* out, int max_out);
+
+#endif
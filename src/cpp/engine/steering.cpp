@@ -0,0 +1,296 @@
+#include "steering.h"
+#include "simd.h"
+#include <cmath>
+
+#define STEERING_SOFTENING 1.0f // px^2 added to distances so coincident entities stay finite
+
+// Neighbour lists of SIMD_WIDTH entities, neighbour-major: slot n of lane l
+// is at [n * SIMD_WIDTH + l]. Unused slots have zero weights.
+struct NeighbourLanes {
+    float x[STEERING_MAX_NEIGHBOURS * SIMD_WIDTH];
+    float y[STEERING_MAX_NEIGHBOURS * SIMD_WIDTH];
+    float vx[STEERING_MAX_NEIGHBOURS * SIMD_WIDTH];
+    float vy[STEERING_MAX_NEIGHBOURS * SIMD_WIDTH];
+    float mate[STEERING_MAX_NEIGHBOURS * SIMD_WIDTH];  // 1 for a teammate
+    float rival[STEERING_MAX_NEIGHBOURS * SIMD_WIDTH]; // 1 for another team
+};
+
+SteeringParams steering_default_params(float max_speed) {
+    SteeringParams params;
+    params.radius = 50.0f;
+    params.separation = 4000.0f;
+    params.alignment = 2.0f;
+    params.cohesion = 1.0f;
+    params.avoidance = 8000.0f;
+    params.max_speed = max_speed;
+    return params;
+}
+
+void steering_cells_resize(SteeringCells& cells, int count) {
+    cells.x.resize(count + SIMD_WIDTH); // read a vector at a time by scan_cell
+    cells.y.resize(count + SIMD_WIDTH);
+    cells.vx.resize(count);
+    cells.vy.resize(count);
+    cells.team.resize(count);
+}
+
+void steering_gather(const SpatialGrid& grid, const float* x, const float* y, const float* vx, const float* vy,
+                     const int32_t* team, int begin, int end, SteeringCells& cells) {
+    const int32_t* cell_entities = grid.cell_entities.data();
+    for (int k = begin; k < end; k++) {
+        int i = cell_entities[k];
+        cells.x[k] = x[i];
+        cells.y[k] = y[i];
+        cells.vx[k] = vx[i];
+        cells.vy[k] = vy[i];
+        cells.team[k] = team[i];
+    }
+}
+
+// Appends neighbours of grid position a from one cell until the budget is full.
+// Candidates are tested a vector at a time and taken in grid order; the cell
+// arrays are padded so the last vector of the last cell stays in bounds.
+static int scan_cell(const SpatialGrid& grid, int cell, const float* x, const float* y, int a, float radius_sq,
+                     int32_t* out, int found) {
+    int end = grid.cell_start[cell + 1];
+    simd_f32 ax = simd_splat(x[a]), ay = simd_splat(y[a]), range_sq = simd_splat(radius_sq);
+    for (int k = grid.cell_start[cell]; k < end && found < STEERING_MAX_NEIGHBOURS; k += SIMD_WIDTH) {
+        simd_f32 dx = simd_sub(simd_load(x + k), ax), dy = simd_sub(simd_load(y + k), ay);
+        unsigned in_range = simd_movemask(simd_cmplt(simd_add(simd_mul(dx, dx), simd_mul(dy, dy)), range_sq));
+        if (end - k < SIMD_WIDTH) in_range &= (1u << (end - k)) - 1u;
+        if (a >= k && a < k + SIMD_WIDTH) in_range &= ~(1u << (a - k));
+        for (int l = 0; in_range && found < STEERING_MAX_NEIGHBOURS; l++, in_range >>= 1) {
+            if (in_range & 1u) out[found++] = k + l;
+        }
+    }
+    return found;
+}
+
+static int find_neighbours(const SpatialGrid& grid, const SteeringCells& cells, int a, float radius, int32_t* out) {
+    const float* x = cells.x.data();
+    const float* y = cells.y.data();
+    float radius_sq = radius * radius;
+    int own_cx = spatial_grid_axis_cell(grid, x[a]), own_cy = spatial_grid_axis_cell(grid, y[a]);
+    int found = scan_cell(grid, own_cy * grid.cells_per_side + own_cx, x, y, a, radius_sq, out, 0);
+
+    int min_cx = spatial_grid_axis_cell(grid, x[a] - radius), max_cx = spatial_grid_axis_cell(grid, x[a] + radius);
+    int min_cy = spatial_grid_axis_cell(grid, y[a] - radius), max_cy = spatial_grid_axis_cell(grid, y[a] + radius);
+    for (int cy = min_cy; cy <= max_cy && found < STEERING_MAX_NEIGHBOURS; cy++) {
+        for (int cx = min_cx; cx <= max_cx && found < STEERING_MAX_NEIGHBOURS; cx++) {
+            if (cx == own_cx && cy == own_cy) continue;
+            found = scan_cell(grid, cy * grid.cells_per_side + cx, x, y, a, radius_sq, out, found);
+        }
+    }
+    return found;
+}
+
+// Fills lane `lane` with the neighbours of grid position a. Padding sits on
+// the entity itself with zero weights, so it adds exact zeros.
+static void gather_lane(const SpatialGrid& grid, const SteeringCells& cells, float radius, int a, int lane,
+                        NeighbourLanes& lanes) {
+    int32_t neighbours[STEERING_MAX_NEIGHBOURS];
+    int found = find_neighbours(grid, cells, a, radius, neighbours);
+    for (int n = 0; n < STEERING_MAX_NEIGHBOURS; n++) {
+        int slot = n * SIMD_WIDTH + lane;
+        int k = n < found ? neighbours[n] : a;
+        float mate = n < found && cells.team[k] == cells.team[a] ? 1.0f : 0.0f;
+        lanes.x[slot] = cells.x[k];
+        lanes.y[slot] = cells.y[k];
+        lanes.vx[slot] = cells.vx[k];
+        lanes.vy[slot] = cells.vy[k];
+        lanes.mate[slot] = mate;
+        lanes.rival[slot] = n < found ? 1.0f - mate : 0.0f;
+    }
+}
+
+// Force terms of a vector of entities, summed over their neighbours
+struct NeighbourSums {
+    simd_f32 sep_x = simd_splat(0.0f), sep_y = simd_splat(0.0f);
+    simd_f32 avoid_x = simd_splat(0.0f), avoid_y = simd_splat(0.0f);
+    simd_f32 align_x = simd_splat(0.0f), align_y = simd_splat(0.0f);
+    simd_f32 centre_x = simd_splat(0.0f), centre_y = simd_splat(0.0f);
+    simd_f32 mates = simd_splat(0.0f);
+};
+
+// Adds one neighbour per lane at offset (dx, dy) from the entity. A lane with
+// zero weights adds exact zeros, which leave its sums as they were.
+static inline void add_neighbour(NeighbourSums& sums, simd_f32 dx, simd_f32 dy, simd_f32 nvx, simd_f32 nvy,
+                                 simd_f32 mate, simd_f32 rival) {
+    // Repulsion falls off with distance: d / |d|^2
+    simd_f32 inv_dist_sq = simd_div(simd_splat(1.0f), simd_add(simd_add(simd_mul(dx, dx), simd_mul(dy, dy)),
+                                                               simd_splat(STEERING_SOFTENING)));
+    simd_f32 away_x = simd_mul(dx, inv_dist_sq), away_y = simd_mul(dy, inv_dist_sq);
+    sums.sep_x = simd_add(sums.sep_x, simd_mul(away_x, mate));
+    sums.sep_y = simd_add(sums.sep_y, simd_mul(away_y, mate));
+    sums.avoid_x = simd_add(sums.avoid_x, simd_mul(away_x, rival));
+    sums.avoid_y = simd_add(sums.avoid_y, simd_mul(away_y, rival));
+
+    sums.align_x = simd_add(sums.align_x, simd_mul(nvx, mate));
+    sums.align_y = simd_add(sums.align_y, simd_mul(nvy, mate));
+    sums.centre_x = simd_sub(sums.centre_x, simd_mul(dx, mate));
+    sums.centre_y = simd_sub(sums.centre_y, simd_mul(dy, mate));
+    sums.mates = simd_add(sums.mates, mate);
+}
+
+static inline int own_cell(const SpatialGrid& grid, float x, float y) {
+    return spatial_grid_axis_cell(grid, y) * grid.cells_per_side + spatial_grid_axis_cell(grid, x);
+}
+
+// When grid positions [a, a + SIMD_WIDTH) share their own cell, which is the
+// usual case in a crowd, walks that cell once for all of them: each candidate
+// is a neighbour of the lanes it is in range of, until a lane's budget is
+// full, which is the order find_neighbours takes them in. False, with sums
+// to be discarded, when the lanes are split across cells or some lane needs
+// the cells around its own to fill its budget.
+static bool scan_shared_cell(const SpatialGrid& grid, const SteeringCells& cells, float radius, int a, simd_f32 px,
+                             simd_f32 py, NeighbourSums& sums) {
+    const float* x = cells.x.data();
+    const float* y = cells.y.data();
+    const int32_t* team = cells.team.data();
+    int cell = own_cell(grid, x[a], y[a]);
+    float index[SIMD_WIDTH], own_team[SIMD_WIDTH];
+    for (int lane = 0; lane < SIMD_WIDTH; lane++) {
+        if (own_cell(grid, x[a + lane], y[a + lane]) != cell) return false;
+        index[lane] = (float)(a + lane); // exact below 2^24 entities
+        own_team[lane] = (float)team[a + lane];
+    }
+
+    simd_f32 zero = simd_splat(0.0f), one = simd_splat(1.0f);
+    simd_f32 range_sq = simd_splat(radius * radius), budget = simd_splat((float)STEERING_MAX_NEIGHBOURS);
+    simd_f32 self = simd_load(index), lane_team = simd_load(own_team), found = zero;
+    simd_f32 open = simd_cmplt(found, budget);
+    int end = grid.cell_start[cell + 1];
+    for (int k = grid.cell_start[cell]; k < end && simd_any(open); k++) {
+        simd_f32 dx = simd_sub(px, simd_splat(x[k])), dy = simd_sub(py, simd_splat(y[k]));
+        simd_f32 take = simd_and(simd_cmplt(simd_add(simd_mul(dx, dx), simd_mul(dy, dy)), range_sq), open);
+        take = simd_select(simd_cmpeq(self, simd_splat((float)k)), zero, take);
+        simd_f32 same = simd_cmpeq(lane_team, simd_splat((float)team[k]));
+        add_neighbour(sums, dx, dy, simd_splat(cells.vx[k]), simd_splat(cells.vy[k]),
+                      simd_select(simd_and(take, same), one, zero), simd_select(same, zero, simd_select(take, one, zero)));
+        found = simd_add(found, simd_select(take, one, zero));
+        open = simd_cmplt(found, budget);
+    }
+    return !simd_any(open);
+}
+
+void steering_update(const SpatialGrid& grid, const SteeringCells& cells, const SteeringParams& params,
+                     float delta_time, int begin, int end, const uint8_t* skip, float* out_vx, float* out_vy) {
+    const int32_t* cell_entities = grid.cell_entities.data();
+    NeighbourLanes lanes;
+    simd_f32 zero = simd_splat(0.0f);
+    simd_f32 one = simd_splat(1.0f);
+    simd_f32 separation = simd_splat(params.separation);
+    simd_f32 alignment = simd_splat(params.alignment);
+    simd_f32 cohesion = simd_splat(params.cohesion);
+    simd_f32 avoidance = simd_splat(params.avoidance);
+    simd_f32 max_speed = simd_splat(params.max_speed);
+    simd_f32 dt = simd_splat(delta_time);
+    float steered_x[SIMD_WIDTH], steered_y[SIMD_WIDTH];
+
+    int a = begin;
+    for (; a + SIMD_WIDTH <= end; a += SIMD_WIDTH) {
+        if (skip) {
+            bool needed = false;
+            for (int lane = 0; lane < SIMD_WIDTH; lane++) needed |= skip[cell_entities[a + lane]] == 0;
+            if (!needed) continue;
+        }
+        simd_f32 px = simd_load(cells.x.data() + a), py = simd_load(cells.y.data() + a);
+        simd_f32 pvx = simd_load(cells.vx.data() + a), pvy = simd_load(cells.vy.data() + a);
+        NeighbourSums sums;
+        if (!scan_shared_cell(grid, cells, params.radius, a, px, py, sums)) {
+            for (int lane = 0; lane < SIMD_WIDTH; lane++) {
+                gather_lane(grid, cells, params.radius, a + lane, lane, lanes);
+            }
+            sums = NeighbourSums();
+            for (int n = 0; n < STEERING_MAX_NEIGHBOURS; n++) {
+                const int slot = n * SIMD_WIDTH;
+                add_neighbour(sums, simd_sub(px, simd_load(lanes.x + slot)), simd_sub(py, simd_load(lanes.y + slot)),
+                              simd_load(lanes.vx + slot), simd_load(lanes.vy + slot), simd_load(lanes.mate + slot),
+                              simd_load(lanes.rival + slot));
+            }
+        }
+
+        // Averages over teammates; no teammates, no alignment or cohesion
+        simd_f32 has_mates = simd_cmpgt(sums.mates, zero);
+        simd_f32 inv_mates = simd_select(has_mates, simd_div(one, simd_max(sums.mates, one)), zero);
+        simd_f32 own_vx = simd_select(has_mates, pvx, zero), own_vy = simd_select(has_mates, pvy, zero);
+
+        simd_f32 steer_x = simd_add(simd_add(simd_mul(sums.sep_x, separation), simd_mul(sums.avoid_x, avoidance)),
+                                    simd_add(simd_mul(simd_sub(simd_mul(sums.align_x, inv_mates), own_vx), alignment),
+                                             simd_mul(simd_mul(sums.centre_x, inv_mates), cohesion)));
+        simd_f32 steer_y = simd_add(simd_add(simd_mul(sums.sep_y, separation), simd_mul(sums.avoid_y, avoidance)),
+                                    simd_add(simd_mul(simd_sub(simd_mul(sums.align_y, inv_mates), own_vy), alignment),
+                                             simd_mul(simd_mul(sums.centre_y, inv_mates), cohesion)));
+
+        simd_f32 nvx = simd_add(pvx, simd_mul(steer_x, dt));
+        simd_f32 nvy = simd_add(pvy, simd_mul(steer_y, dt));
+        simd_f32 speed = simd_sqrt(simd_add(simd_mul(nvx, nvx), simd_mul(nvy, nvy)));
+        simd_f32 scale = simd_select(simd_cmpgt(speed, max_speed), simd_div(max_speed, speed), one);
+        simd_store(steered_x, simd_mul(nvx, scale));
+        simd_store(steered_y, simd_mul(nvy, scale));
+        for (int lane = 0; lane < SIMD_WIDTH; lane++) {
+            int i = cell_entities[a + lane];
+            out_vx[i] = steered_x[lane];
+            out_vy[i] = steered_y[lane];
+        }
+    }
+
+    // Tail entities that do not fill a whole vector
+    if (a < end) {
+        steering_update_reference(grid, cells, params, delta_time, a, end, skip, out_vx, out_vy);
+    }
+}
+
+void steering_update_reference(const SpatialGrid& grid, const SteeringCells& cells, const SteeringParams& params,
+                               float delta_time, int begin, int end, const uint8_t* skip, float* out_vx,
+                               float* out_vy) {
+    const float* x = cells.x.data();
+    const float* y = cells.y.data();
+    const float* vx = cells.vx.data();
+    const float* vy = cells.vy.data();
+    const int32_t* team = cells.team.data();
+    int32_t neighbours[STEERING_MAX_NEIGHBOURS];
+
+    for (int a = begin; a < end; a++) {
+        if (skip && skip[grid.cell_entities[a]]) continue;
+        int found = find_neighbours(grid, cells, a, params.radius, neighbours);
+        float sep_x = 0.0f, sep_y = 0.0f, avoid_x = 0.0f, avoid_y = 0.0f;
+        float align_x = 0.0f, align_y = 0.0f, centre_x = 0.0f, centre_y = 0.0f, mates = 0.0f;
+
+        // Same padded loop as the vector version so both round alike
+        for (int n = 0; n < STEERING_MAX_NEIGHBOURS; n++) {
+            int k = n < found ? neighbours[n] : a;
+            float mate = n < found && team[k] == team[a] ? 1.0f : 0.0f;
+            float rival = n < found ? 1.0f - mate : 0.0f;
+            float dx = x[a] - x[k], dy = y[a] - y[k];
+
+            float inv_dist_sq = 1.0f / (dx * dx + dy * dy + STEERING_SOFTENING);
+            float away_x = dx * inv_dist_sq, away_y = dy * inv_dist_sq;
+            sep_x += away_x * mate;
+            sep_y += away_y * mate;
+            avoid_x += away_x * rival;
+            avoid_y += away_y * rival;
+
+            align_x += vx[k] * mate;
+            align_y += vy[k] * mate;
+            centre_x -= dx * mate;
+            centre_y -= dy * mate;
+            mates += mate;
+        }
+
+        float inv_mates = mates > 0.0f ? 1.0f / mates : 0.0f;
+        float own_vx = mates > 0.0f ? vx[a] : 0.0f, own_vy = mates > 0.0f ? vy[a] : 0.0f;
+        float steer_x = (sep_x * params.separation + avoid_x * params.avoidance) +
+                        ((align_x * inv_mates - own_vx) * params.alignment + centre_x * inv_mates * params.cohesion);
+        float steer_y = (sep_y * params.separation + avoid_y * params.avoidance) +
+                        ((align_y * inv_mates - own_vy) * params.alignment + centre_y * inv_mates * params.cohesion);
+
+        float nvx = vx[a] + steer_x * delta_time;
+        float nvy = vy[a] + steer_y * delta_time;
+        float speed = sqrtf(nvx * nvx + nvy * nvy);
+        float scale = speed > params.max_speed ? params.max_speed / speed : 1.0f;
+        int i = grid.cell_entities[a];
+        out_vx[i] = nvx * scale;
+        out_vy[i] = nvy * scale;
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef STEERING_H
+#define STEERING_H
+
+#include "spatial_grid.h"
+#include <cstdint>
+#include <vector>
+
+// Team steering for swarms: separation from teammates, alignment with their
+// velocity, cohesion towards their centre and avoidance of other teams.
+//
+// An entity's neighbourhood is the first STEERING_MAX_NEIGHBOURS entities
+// within the radius, scanning its own grid cell first and then the cells
+// around it in grid order. The scan stops once the budget is full, so an
+// entity in a crowd costs about the same as one in open space, and the lists
+// are padded to the budget so the force terms are accumulated SIMD_WIDTH
+// entities at a time with no per-lane loop counts.
+//
+// Like collision, everything runs on copies of the entity state in grid
+// order, and entities are processed in that order, so a scan reads its cells
+// contiguously and neighbouring entities share them in cache.
+
+#define STEERING_MAX_NEIGHBOURS 8
+
+struct SteeringParams {
+    float radius;     // neighbourhood radius in pixels
+    float separation; // weights of the force terms
+    float alignment;
+    float cohesion;
+    float avoidance;
+    float max_speed;  // steered velocities are clamped to this
+};
+
+SteeringParams steering_default_params(float max_speed);
+
+// Entity state in grid order: element k belongs to grid.cell_entities[k]
+struct SteeringCells {
+    std::vector<float> x, y, vx, vy;
+    std::vector<int32_t> team;
+};
+
+// Sizes cells for the grid's entity count, then copies grid positions
+// [begin, end); ranges can be gathered in parallel.
+void steering_cells_resize(SteeringCells& cells, int count);
+void steering_gather(const SpatialGrid& grid, const float* x, const float* y, const float* vx, const float* vy,
+                     const int32_t* team, int begin, int end, SteeringCells& cells);
+
+// Steered velocities of the entities at grid positions [begin, end), written
+// to out_vx/out_vy at their store index. Only out is written, so disjoint
+// ranges can run in parallel. Entities with skip[i] set (by store index; skip
+// may be null) need no result: their out is left unspecified, and vectors of
+// skipped entities are not computed at all.
+void steering_update(const SpatialGrid& grid, const SteeringCells& cells, const SteeringParams& params,
+                     float delta_time, int begin, int end, const uint8_t* skip, float* out_vx, float* out_vy);
+
+// One entity at a time with scalar arithmetic. The vector version must match
+// it bit for bit.
+void steering_update_reference(const SpatialGrid& grid, const SteeringCells& cells, const SteeringParams& params,
+                               float delta_time, int begin, int end, const uint8_t* skip, float* out_vx,
+                               float* out_vy);
+
+#endif
@@ -0,0 +1,51 @@
+#include "timing_wheel.h"
+
+void timing_wheel_init(TimingWheel& wheel, int slots, int capacity) {
+    uint32_t size = 1;
+    while (size < (uint32_t)slots) size <<= 1;
+    wheel.mask = size - 1;
+    wheel.head.assign(size, -1);
+
+    size_t ids = capacity > 0 ? (size_t)capacity : 0;
+    wheel.next.assign(ids, -1);
+    wheel.prev.assign(ids, -1);
+    wheel.slot_of.assign(ids, -1);
+}
+
+void timing_wheel_clear(TimingWheel& wheel) {
+    wheel.head.assign(wheel.head.size(), -1);
+    wheel.slot_of.assign(wheel.slot_of.size(), -1);
+}
+
+void timing_wheel_cancel(TimingWheel& wheel, uint32_t id) {
+    int32_t slot = wheel.slot_of[id];
+    if (slot < 0) return;
+
+    int32_t next = wheel.next[id], prev = wheel.prev[id];
+    if (prev >= 0) wheel.next[prev] = next;
+    else wheel.head[slot] = next;
+    if (next >= 0) wheel.prev[next] = prev;
+    wheel.slot_of[id] = -1;
+}
+
+void timing_wheel_schedule(TimingWheel& wheel, uint32_t id, uint32_t tick) {
+    timing_wheel_cancel(wheel, id);
+
+    int32_t slot = (int32_t)(tick & wheel.mask);
+    int32_t first = wheel.head[slot];
+    wheel.next[id] = first;
+    wheel.prev[id] = -1;
+    if (first >= 0) wheel.prev[first] = (int32_t)id;
+    wheel.head[slot] = (int32_t)id;
+    wheel.slot_of[id] = slot;
+}
+
+void timing_wheel_take(TimingWheel& wheel, uint32_t tick, std::vector<uint32_t>& out) {
+    out.clear();
+    int32_t slot = (int32_t)(tick & wheel.mask);
+    for (int32_t id = wheel.head[slot]; id >= 0; id = wheel.next[id]) {
+        out.push_back((uint32_t)id);
+        wheel.slot_of[id] = -1;
+    }
+    wheel.head[slot] = -1;
+}
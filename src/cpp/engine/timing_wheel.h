@@ -0,0 +1,32 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Single-level timing wheel of ids keyed on simulation tick. An id scheduled
+// for tick t is linked into slot t % slots, so firing a tick costs the ids in
+// one slot rather than a scan of every entity. Lists are intrusive over ids
+// below the wheel's capacity, so scheduling, rescheduling and cancelling are
+// O(1) and never allocate. Ids scheduled a whole lap or more ahead share the
+// slot with nearer ones; the caller checks each taken id against the tick it
+// is really due and schedules it again if it is early.
+struct TimingWheel {
+    std::vector<int32_t> head;    // first id of each slot, -1 when empty
+    std::vector<int32_t> next;    // per id, -1 at the end of a slot
+    std::vector<int32_t> prev;    // per id, -1 at the head of a slot
+    std::vector<int32_t> slot_of; // per id, -1 when not scheduled
+    uint32_t mask;
+};
+
+// slots is rounded up to a power of two; ids must be below capacity
+void timing_wheel_init(TimingWheel& wheel, int slots, int capacity);
+void timing_wheel_clear(TimingWheel& wheel);
+// Moves the id if it is already scheduled
+void timing_wheel_schedule(TimingWheel& wheel, uint32_t id, uint32_t tick);
+void timing_wheel_cancel(TimingWheel& wheel, uint32_t id);
+// Replaces out with the ids in tick's slot, which is left empty
+void timing_wheel_take(TimingWheel& wheel, uint32_t tick, std::vector<uint32_t>& out);
+
+#endif
@@ -0,0 +1,99 @@
+#include "worker_thread.h"
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+#define WORKER_THREAD_THREADS 0
+#else
+#define WORKER_THREAD_THREADS 1
+#endif
+
+#if WORKER_THREAD_THREADS
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+static std::thread g_thread;
+static std::mutex g_mutex;
+static std::condition_variable g_task_ready;
+static std::condition_variable g_task_done;
+static WorkerTaskFn g_task = nullptr; // pending or running task, null when idle
+static void* g_task_data = nullptr;
+static bool g_running = false;
+
+static void thread_main() {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    while (true) {
+        g_task_ready.wait(lock, [] { return g_task != nullptr || !g_running; });
+        if (!g_running) return;
+
+        WorkerTaskFn fn = g_task;
+        void* user_data = g_task_data;
+        lock.unlock();
+        fn(user_data);
+        lock.lock();
+
+        g_task = nullptr;
+        g_task_done.notify_all();
+    }
+}
+
+bool worker_thread_available() {
+    return true;
+}
+
+void worker_thread_start(WorkerTaskFn fn, void* user_data) {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    g_task_done.wait(lock, [] { return g_task == nullptr; });
+
+    // Started lazily so builds that never go async never spawn the thread
+    if (!g_running) {
+        g_running = true;
+        g_thread = std::thread(thread_main);
+    }
+
+    g_task = fn;
+    g_task_data = user_data;
+    g_task_ready.notify_one();
+}
+
+void worker_thread_wait() {
+    std::unique_lock<std::mutex> lock(g_mutex);
+    g_task_done.wait(lock, [] { return g_task == nullptr; });
+}
+
+bool worker_thread_busy() {
+    std::lock_guard<std::mutex> lock(g_mutex);
+    return g_task != nullptr;
+}
+
+void worker_thread_shutdown() {
+    {
+        std::unique_lock<std::mutex> lock(g_mutex);
+        g_task_done.wait(lock, [] { return g_task == nullptr; });
+        if (!g_running) return;
+        g_running = false;
+    }
+    g_task_ready.notify_one();
+    g_thread.join();
+}
+
+#else
+
+bool worker_thread_available() {
+    return false;
+}
+
+void worker_thread_start(WorkerTaskFn fn, void* user_data) {
+    fn(user_data);
+}
+
+void worker_thread_wait() {
+}
+
+bool worker_thread_busy() {
+    return false;
+}
+
+void worker_thread_shutdown() {
+}
+
+#endif
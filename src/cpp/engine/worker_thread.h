@@ -0,0 +1,23 @@
+#ifndef WORKER_THREAD_H
+#define WORKER_THREAD_H
+
+// One long-lived background thread that runs a single task at a time, e.g. the
+// next simulation step while the main thread renders the previous one. The
+// task may itself use job_system_parallel_for, as long as no other thread is
+// inside parallel_for at the same time.
+//
+// Builds without thread support run the task inline in worker_thread_start.
+
+typedef void (*WorkerTaskFn)(void* user_data);
+
+// False when tasks would just run inline
+bool worker_thread_available();
+
+// Waits for any previous task, then hands fn to the thread and returns
+void worker_thread_start(WorkerTaskFn fn, void* user_data);
+// Blocks until the current task (if any) has finished
+void worker_thread_wait();
+bool worker_thread_busy();
+void worker_thread_shutdown();
+
+#endif
@@ -0,0 +1,673 @@
+#include "world.h"
+#include "movement.h"
+#include "rng.h"
+#include "job_system.h"
+#include "collision.h"
+#include <algorithm>
+#include <cmath>  // for sin, cos
+#include <cstring>
+#include <new>
+
+#define DECISION_BATCH 64 // entities whose random rolls are generated together
+#define UPDATE_CHUNK WORLD_UPDATE_CHUNK
+#define DECISION_CHUNK 1024 // fired decisions per job, a multiple of DECISION_BATCH
+#define DECISION_WHEEL_SLOTS 1024 // ticks per lap of the decision wheel
+#define DECISION_MAX_STEPS 1000000.0f // cap on the steps to the next decision
+#define FLOW_SEEK_RATE 4.0f // per second, how fast velocities turn onto the flow field
+
+// Every job of a step gets its world as user data
+static void world_parallel_for(World& world, int count, int chunk_size, JobRangeFn fn) {
+    if (!world.serial) {
+        job_system_parallel_for(count, chunk_size, fn, &world);
+        return;
+    }
+    for (int begin = 0; begin < count; begin += chunk_size) {
+        fn(begin, std::min(begin + chunk_size, count), &world);
+    }
+}
+
+// Re-roll direction, speed and next decision tick for fired[begin, end).
+// Random values come from the counter-based generator keyed by entity id and
+// decision count, so the result does not depend on how the range is split up.
+static void run_decisions(int begin, int end, void* user_data) {
+    World& world = *(World*)user_data;
+    float delta_time = world.delta_time;
+    float* vx = world.entities.vx;
+    float* vy = world.entities.vy;
+    uint32_t* decision_tick = world.entities.decision_tick;
+    uint32_t* decision_count = world.entities.decision_count;
+    const uint32_t* ids = world.entities.id;
+    const int32_t* fired = world.fired.data();
+
+    uint32_t fired_ids[DECISION_BATCH];
+    uint32_t counters[DECISION_BATCH];
+    float rolls[4 * DECISION_BATCH];
+
+    for (int batch_start = begin; batch_start < end; batch_start += DECISION_BATCH) {
+        int num_fired = end - batch_start < DECISION_BATCH ? end - batch_start : DECISION_BATCH;
+        for (int k = 0; k < num_fired; k++) {
+            int i = fired[batch_start + k];
+            fired_ids[k] = ids[i];
+            counters[k] = decision_count[i]++;
+        }
+
+        // One lane of random rolls per fired entity: angle, speed, timer
+        rng_uniform4_lanes(world.seed, fired_ids, counters, num_fired, RNG_STREAM_DECISION, rolls);
+        const float* angle_roll = rolls;
+        const float* speed_roll = rolls + num_fired;
+        const float* timer_roll = rolls + 2 * num_fired;
+
+        for (int k = 0; k < num_fired; k++) {
+            int i = fired[batch_start + k];
+
+            // Random direction (0-360 degrees)
+            float angle = angle_roll[k] * 6.283185f; // 2 * PI
+            float speed = world.ai_speed * (0.5f + speed_roll[k] * 0.5f); // 50-100% of base speed
+
+            vx[i] = cos(angle) * speed;
+            vy[i] = sin(angle) * speed;
+
+            // Next decision in 1-3 seconds, as whole steps of the current length
+            float seconds = 1.0f + timer_roll[k] * 2.0f;
+            float steps = delta_time > 0.0f ? ceilf(seconds / delta_time) : 1.0f;
+            if (steps < 1.0f) steps = 1.0f;
+            if (steps > DECISION_MAX_STEPS) steps = DECISION_MAX_STEPS;
+            decision_tick[i] = world.tick + (uint32_t)steps;
+        }
+    }
+}
+
+// Entities whose slot comes up this tick and that are due now; ids scheduled
+// a lap or more ahead go back into the wheel
+static void collect_due_decisions(World& world) {
+    world.fired.clear();
+    timing_wheel_take(world.decision_wheel, world.tick, world.due_ids);
+
+    for (uint32_t id : world.due_ids) {
+        int index = entity_store_index_of(world.entities, id);
+        if (index < 0) continue;
+
+        uint32_t due = world.entities.decision_tick[index];
+        if (due <= world.tick) world.fired.push_back(index);
+        else timing_wheel_schedule(world.decision_wheel, id, due);
+    }
+}
+
+// Every live entity into a fresh wheel, e.g. after a load
+static void schedule_all_decisions(World& world) {
+    EntityStore& entities = world.entities;
+    timing_wheel_init(world.decision_wheel, DECISION_WHEEL_SLOTS, entities.capacity);
+    for (int i = 0; i < entities.count; i++) {
+        if (entities.decision_tick[i] < world.tick) entities.decision_tick[i] = world.tick;
+        timing_wheel_schedule(world.decision_wheel, entities.id[i], entities.decision_tick[i]);
+    }
+}
+
+// Streaming part of a step for one contiguous chunk: no decisions and no
+// branches on timers. Chunks touch disjoint entities, so they can run on any
+// worker in any order and still give the same world.
+static void gather_steering_chunk(int begin, int end, void* user_data) {
+    World& world = *(World*)user_data;
+    const EntityStore& entities = world.entities;
+    steering_gather(world.spatial_grid, entities.x, entities.y, entities.vx, entities.vy, entities.team,
+                    begin, end, world.steering_cells);
+}
+
+// Steered velocities for a chunk of the grid order
+static void steer_chunk(int begin, int end, void* user_data) {
+    World& world = *(World*)user_data;
+    steering_update(world.spatial_grid, world.steering_cells, world.steering, world.delta_time, begin, end,
+                    world.lod_active ? world.lod_tier.data() : nullptr, world.steer_vx.data(),
+                    world.steer_vy.data());
+}
+
+// Bring one team's flow field up to date with its queued changes
+static void flow_team_job(int begin, int end, void* user_data) {
+    World& world = *(World*)user_data;
+    for (int t = begin; t < end; t++) flow_field_update_team(world.flow, t);
+}
+
+// Take the steered velocities and turn goal seekers towards their team's
+// flow direction, one field lookup per entity. Under level of detail only
+// tier 0 flocks, and seekers turn as far as the steps they take this tick.
+static void turn_chunk(World& world, int begin, int end) {
+    const EntityStore& entities = world.entities;
+    const FlowField& flow = world.flow;
+    float delta_time = world.delta_time;
+    bool flocking = world.ai_behaviour == AI_BEHAVIOUR_FLOCK;
+    float* vx = entities.vx;
+    float* vy = entities.vy;
+    const float* steer_vx = world.steer_vx.data();
+    const float* steer_vy = world.steer_vy.data();
+    uint8_t* turned = world.turned.data();
+    const uint8_t* tier = world.lod_active ? world.lod_tier.data() : nullptr;
+    const float* steps = world.lod_active ? world.lod_steps.data() : nullptr;
+    const float seek = std::min(1.0f, FLOW_SEEK_RATE * delta_time);
+
+    // Cells without a direction look up a zero vector and turn by zero
+    float target_x[FLOW_NO_DIRECTION + 1], target_y[FLOW_NO_DIRECTION + 1], rate[FLOW_NO_DIRECTION + 1];
+    for (int d = 0; d <= FLOW_NO_DIRECTION; d++) {
+        bool moving = d != FLOW_NO_DIRECTION;
+        if (moving) flow_field_direction_vector(d, &target_x[d], &target_y[d]);
+        target_x[d] = moving ? target_x[d] * world.ai_speed : 0.0f;
+        target_y[d] = moving ? target_y[d] * world.ai_speed : 0.0f;
+        rate[d] = moving ? 1.0f : 0.0f;
+    }
+
+    for (int i = begin; i < end; i++) {
+        bool steered = flocking && (!tier || tier[i] == 0);
+        float nvx = steered ? steer_vx[i] : vx[i];
+        float nvy = steered ? steer_vy[i] : vy[i];
+        if (world.flow_seeking) {
+            uint32_t team = (uint32_t)entities.team[i];
+            int d = team < FLOW_MAX_TEAMS
+                        ? flow.teams[team].direction[flow_field_cell(flow, entities.x[i], entities.y[i])]
+                        : FLOW_NO_DIRECTION;
+            float turn = rate[d] * (steps ? std::min(1.0f, FLOW_SEEK_RATE * delta_time * steps[i]) : seek);
+            nvx += (target_x[d] - nvx) * turn;
+            nvy += (target_y[d] - nvy) * turn;
+        }
+        turned[i] = nvx != vx[i] || nvy != vy[i];
+        vx[i] = nvx;
+        vy[i] = nvy;
+    }
+}
+
+static void update_chunk(int begin, int end, void* user_data) {
+    World& world = *(World*)user_data;
+    EntityStore& entities = world.entities;
+    float delta_time = world.delta_time;
+    float bounds = world.world_bounds;
+    bool turning = world.ai_behaviour == AI_BEHAVIOUR_FLOCK || world.flow_seeking;
+
+    // Which entities step this tick, and over how many ticks
+    if (world.lod_active) {
+        lod_schedule(world.lod, world.tick, entities.id, world.lod_tier.data(), world.lod_stepped_tick.data(),
+                     world.lod_steps.data(), begin, end);
+    }
+
+    if (turning) turn_chunk(world, begin, end);
+
+    // Keep the pre-step positions for render interpolation
+    memcpy(entities.prev_x + begin, entities.x + begin, (end - begin) * sizeof(float));
+    memcpy(entities.prev_y + begin, entities.y + begin, (end - begin) * sizeof(float));
+
+    // Integrate positions and bounce off the world edges several entities at a time
+    if (world.lod_active) {
+        integrate_and_bounce_steps(entities.x + begin, entities.y + begin, entities.vx + begin, entities.vy + begin,
+                                   world.lod_steps.data() + begin, end - begin, delta_time, bounds);
+        lod_assign_tiers(world.lod, world.lod_views, entities.x, entities.y, world.lod_steps.data(),
+                         world.lod_tier.data(), begin, end);
+    } else {
+        integrate_and_bounce(entities.x + begin, entities.y + begin, entities.vx + begin, entities.vy + begin,
+                             end - begin, delta_time, bounds);
+    }
+
+    // Bounces turn entities too, and leave them clamped exactly onto the edge
+    if (world.replay_recording) {
+        std::vector<int32_t>& corrections = world.chunk_corrections[begin / UPDATE_CHUNK];
+        for (int i = begin; i < end; i++) {
+            if ((turning && world.turned[i]) || fabsf(entities.x[i]) == bounds || fabsf(entities.y[i]) == bounds) {
+                corrections.push_back(i);
+            }
+        }
+    }
+
+    // Bucket the chunk into the spatial grid while its positions are still in cache
+    spatial_grid_assign_cells(world.spatial_grid, entities.x, entities.y, begin, end);
+}
+
+static void gather_chunk(int begin, int end, void* user_data) {
+    World& world = *(World*)user_data;
+    collision_gather(world.spatial_grid, world.entities.x, world.entities.y, begin, end, world.cell_x.data(),
+                     world.cell_y.data());
+}
+
+// Pushes for a chunk of the grid order, from positions every chunk sees unchanged
+static void collide_chunk(int begin, int end, void* user_data) {
+    World& world = *(World*)user_data;
+    world.chunk_contacts[begin / UPDATE_CHUNK] = collision_compute_pushes(
+        world.spatial_grid, world.cell_x.data(), world.cell_y.data(), begin, end,
+        world.lod_active ? world.lod_tier.data() : nullptr, world.push_x.data(), world.push_y.data());
+}
+
+// Apply the pushes, keep entities inside the world and re-bucket them
+static void separate_chunk(int begin, int end, void* user_data) {
+    World& world = *(World*)user_data;
+    float* x = world.entities.x;
+    float* y = world.entities.y;
+    const float* push_x = world.push_x.data();
+    const float* push_y = world.push_y.data();
+    float bounds = world.world_bounds;
+    std::vector<int32_t>* corrections =
+        world.replay_recording ? &world.chunk_corrections[begin / UPDATE_CHUNK] : nullptr;
+
+    for (int i = begin; i < end; i++) {
+        if (push_x[i] == 0.0f && push_y[i] == 0.0f) continue;
+
+        // Bounced entities are already on the replay's list
+        if (corrections && fabsf(x[i]) != bounds && fabsf(y[i]) != bounds) corrections->push_back(i);
+
+        float nx = x[i] + push_x[i], ny = y[i] + push_y[i];
+        x[i] = nx < -bounds ? -bounds : (nx > bounds ? bounds : nx);
+        y[i] = ny < -bounds ? -bounds : (ny > bounds ? bounds : ny);
+    }
+
+    spatial_grid_assign_cells(world.spatial_grid, x, y, begin, end);
+}
+
+// Separate overlapping squares after integration. Pushes are all computed
+// before any entity moves, then applied in a second pass.
+static void resolve_collisions(World& world) {
+    int count = world.entities.count;
+    size_t num_chunks = (size_t)(count + UPDATE_CHUNK - 1) / UPDATE_CHUNK;
+    if (world.push_x.size() < (size_t)count) {
+        world.push_x.resize(count);
+        world.push_y.resize(count);
+        world.cell_x.resize(count);
+        world.cell_y.resize(count);
+    }
+    if (world.chunk_contacts.size() < num_chunks) world.chunk_contacts.resize(num_chunks);
+    // A single worker runs the whole range as one call into the first slot
+    std::fill(world.chunk_contacts.begin(), world.chunk_contacts.begin() + num_chunks, 0);
+
+    world_parallel_for(world, count, UPDATE_CHUNK, gather_chunk);
+    world_parallel_for(world, count, UPDATE_CHUNK, collide_chunk);
+    spatial_grid_begin_rebuild(world.spatial_grid, count);
+    world_parallel_for(world, count, UPDATE_CHUNK, separate_chunk);
+    spatial_grid_rebuild(world.spatial_grid);
+
+    int contacts = 0;
+    for (size_t c = 0; c < num_chunks; c++) contacts += world.chunk_contacts[c];
+    world.collision_contacts = contacts / 2;
+}
+
+// Far tiers catch up on several ticks in one step
+float world_step_max_travel(const World& world) {
+    float ticks = world.lod_enabled ? (float)lod_max_interval(world.lod) : 1.0f;
+    return world.ai_speed * world.fixed_step * ticks + (world.collisions ? COLLISION_MAX_PUSH : 0.0f);
+}
+
+// Integrate a lagging entity up to the current tick at its current velocity
+static void lod_catch_up(World& world, int i) {
+    uint32_t behind = world.tick - world.lod_stepped_tick[i];
+    if (behind == 0) return;
+    float steps = (float)behind;
+    EntityStore& entities = world.entities;
+    integrate_and_bounce_steps_reference(&entities.x[i], &entities.y[i], &entities.vx[i], &entities.vy[i],
+                                         &steps, 1, world.lod_step_time, world.world_bounds);
+    world.lod_stepped_tick[i] = world.tick;
+}
+
+// Everyone up to date and back in tier 0, e.g. before the world is saved or
+// its dense indices move
+void world_lod_sync(World& world) {
+    if (!world.lod_lagging) return;
+    EntityStore& entities = world.entities;
+    for (int i = 0; i < entities.count; i++) {
+        if (world.lod_stepped_tick[i] == world.tick) continue;
+        lod_catch_up(world, i);
+        entities.prev_x[i] = entities.x[i];
+        entities.prev_y[i] = entities.y[i];
+    }
+    std::fill(world.lod_tier.begin(), world.lod_tier.end(), 0);
+    world.lod_lagging = false;
+}
+
+// Tier state for every entity and the view centres for this step
+static void lod_begin_step(World& world) {
+    const EntityStore& entities = world.entities;
+    size_t count = (size_t)entities.count;
+    if (world.lod_tier.size() < count) {
+        world.lod_tier.resize(count, 0);
+        world.lod_stepped_tick.resize(count, world.tick);
+        world.lod_steps.resize(count);
+    }
+    LodViews& views = world.lod_views;
+    views.count = 0;
+    for (uint32_t id = 0; id < NUM_AI_ENTITIES && id < LOD_MAX_VIEWS; id++) {
+        int index = entity_store_index_of(entities, id);
+        if (index < 0) continue;
+        views.x[views.count] = entities.x[index];
+        views.y[views.count] = entities.y[index];
+        views.count++;
+    }
+    world.lod_step_time = world.delta_time;
+    world.lod_lagging = true;
+}
+
+void world_ensure_spatial_grid(World& world) {
+    if (world.spatial_grid_dirty) {
+        spatial_grid_build(world.spatial_grid, world.entities.x, world.entities.y, world.entities.count);
+        world.spatial_grid_dirty = false;
+    }
+}
+
+void world_fill_header(const World& world, WorldFileHeader& header) {
+    memset(&header, 0, sizeof(header));
+    header.capacity = world.entities.capacity;
+    header.count = world.entities.count;
+    header.free_id_count = world.entities.free_id_count;
+    header.seed = world.seed;
+    header.tick = world.tick;
+    header.world_bounds = world.world_bounds;
+    header.ai_speed = world.ai_speed;
+    header.spatial_cell_size = world.spatial_cell_size;
+    header.fixed_step = world.fixed_step;
+    header.accumulator = world.accumulator;
+    world_file_init_header(header);
+}
+
+void world_step(World& world, float delta_time) {
+    EntityStore& entities = world.entities;
+    world.delta_time = delta_time;
+
+    // Replays step every entity every tick, so tiers wait while one records.
+    // Tiers only pay for themselves when a pass scales with neighbours: a
+    // plain random walk steps everyone for less than the catch-up costs.
+    world.lod_active = world.lod_enabled && !world.replay_recording &&
+                       (world.collisions || world.ai_behaviour == AI_BEHAVIOUR_FLOCK);
+    if (world.lod_active) lod_begin_step(world);
+    else if (world.lod_lagging) world_lod_sync(world);
+
+    if (world.replay_recording) {
+        // A keyframe holds the world before this step, at the current tick
+        if (world.replay_keyframe_pending || replay_recorder_keyframe_due(world.replay, world.tick)) {
+            WorldFileHeader header;
+            world_fill_header(world, header);
+            replay_recorder_add_keyframe(world.replay, world.tick, header, entities.block);
+            world.replay_keyframe_pending = false;
+        }
+
+        size_t num_chunks = (size_t)(entities.count + UPDATE_CHUNK - 1) / UPDATE_CHUNK;
+        if (world.chunk_corrections.size() < num_chunks) world.chunk_corrections.resize(num_chunks);
+        for (size_t c = 0; c < num_chunks; c++) world.chunk_corrections[c].clear();
+    }
+
+    // Direction changes due this tick, then their next slots on the wheel
+    collect_due_decisions(world);
+    if (world.lod_active) {
+        // A lagging entity turns where it would have been by now
+        for (int32_t i : world.fired) lod_catch_up(world, i);
+    }
+    if (!world.fired.empty()) {
+        world_parallel_for(world, (int)world.fired.size(), DECISION_CHUNK, run_decisions);
+        for (int32_t i : world.fired) {
+            timing_wheel_schedule(world.decision_wheel, entities.id[i], entities.decision_tick[i]);
+        }
+    }
+
+    // Fields follow goal and obstacle changes before anyone samples them
+    bool flow_pending = false;
+    world.flow_seeking = false;
+    for (int t = 0; t < FLOW_MAX_TEAMS; t++) {
+        flow_pending |= flow_field_team_pending(world.flow, t);
+        world.flow_seeking |= world.flow.teams[t].goal_count > 0;
+    }
+    if (flow_pending) world_parallel_for(world, FLOW_MAX_TEAMS, 1, flow_team_job);
+    if (world.flow_seeking && world.turned.size() < (size_t)entities.count) world.turned.resize(entities.count);
+
+    // Steer from the neighbourhoods at the start of the step
+    if (world.ai_behaviour == AI_BEHAVIOUR_FLOCK) {
+        int count = entities.count;
+        if (world.steer_vx.size() < (size_t)count) {
+            world.steer_vx.resize(count);
+            world.steer_vy.resize(count);
+            world.turned.resize(count);
+            steering_cells_resize(world.steering_cells, count);
+        }
+        world.steering.max_speed = world.ai_speed;
+        world_ensure_spatial_grid(world);
+        world_parallel_for(world, count, UPDATE_CHUNK, gather_steering_chunk);
+        world_parallel_for(world, count, UPDATE_CHUNK, steer_chunk);
+    }
+
+    // Returns only after every chunk has finished, so the world is
+    // complete before anything renders it
+    spatial_grid_begin_rebuild(world.spatial_grid, entities.count);
+    world_parallel_for(world, entities.count, UPDATE_CHUNK, update_chunk);
+    spatial_grid_rebuild(world.spatial_grid);
+    if (world.collisions) resolve_collisions(world);
+    world.spatial_grid_dirty = false;
+
+    world.tick++;
+
+    if (world.replay_recording) {
+        size_t num_chunks = (size_t)(entities.count + UPDATE_CHUNK - 1) / UPDATE_CHUNK;
+        replay_recorder_begin_tick(world.replay, world.tick, delta_time);
+        for (int32_t i : world.fired) {
+            replay_recorder_add_decision(world.replay, entities.id[i], entities.x[i], entities.y[i],
+                                         entities.vx[i], entities.vy[i]);
+        }
+        for (size_t c = 0; c < num_chunks; c++) {
+            for (int32_t i : world.chunk_corrections[c]) {
+                replay_recorder_add_decision(world.replay, entities.id[i], entities.x[i], entities.y[i],
+                                             entities.vx[i], entities.vy[i]);
+            }
+        }
+        replay_recorder_end_tick(world.replay);
+    }
+    world.interpolation_alpha = 1.0f; // nothing pending until world_advance says otherwise
+}
+
+float world_advance(World& world, float frame_time) {
+    if (world.fixed_step <= 0.0f) {
+        world_step(world, frame_time);
+        return world.interpolation_alpha;
+    }
+
+    world.accumulator += frame_time;
+    int steps = 0;
+    while (world.accumulator >= world.fixed_step && steps < world.max_steps_per_frame) {
+        world_step(world, world.fixed_step);
+        world.accumulator -= world.fixed_step;
+        steps++;
+    }
+
+    // Too far behind: drop the backlog rather than spiral, keep the phase
+    if (world.accumulator >= world.fixed_step) {
+        world.accumulator = fmodf(world.accumulator, world.fixed_step);
+    }
+
+    world.interpolation_alpha = world.accumulator / world.fixed_step;
+    return world.interpolation_alpha;
+}
+
+void world_set_fixed_timestep(World& world, float ticks_per_second, int max_steps_per_frame) {
+    world.fixed_step = ticks_per_second > 0.0f ? 1.0f / ticks_per_second : 0.0f;
+    world.max_steps_per_frame = max_steps_per_frame > 0 ? max_steps_per_frame : 1;
+    world.accumulator = 0.0f;
+    world.interpolation_alpha = 1.0f;
+}
+
+// Drop the live entities together with any file mapping they run on
+static void release_entities(World& world) {
+    entity_store_free(world.entities);
+#ifndef __EMSCRIPTEN__
+    world_file_unmap(world.world_mapping);
+#endif
+}
+
+static void free_buffer(World& world) {
+    if (world.world_buffer) {
+        ::operator delete(world.world_buffer, std::align_val_t(ENTITY_STORE_ALIGNMENT));
+        world.world_buffer = nullptr;
+    }
+}
+
+// After the entity set was replaced wholesale: fresh wheel, grid, flow field
+// and tiers
+static void world_replaced(World& world) {
+    world.replay_keyframe_pending = true;
+    schedule_all_decisions(world);
+    spatial_grid_init(world.spatial_grid, world.world_bounds, world.spatial_cell_size);
+    world.spatial_grid_dirty = true;
+    flow_field_init(world.flow, world.world_bounds, world.flow_cell_size);
+    world.lod_tier.assign(world.entities.count, 0);
+    world.lod_stepped_tick.assign(world.entities.count, world.tick);
+    world.lod_steps.resize(world.entities.count);
+    world.lod_lagging = false;
+}
+
+bool world_init(World& world, int max_entities, int initial_entities) {
+    // Initialize AI entities at different starting positions
+    static const float start_positions[4][2] = {
+        {-200.0f, -200.0f}, // Red team
+        {200.0f, -200.0f},  // Blue team
+        {-200.0f, 200.0f},  // Purple team
+        {200.0f, 200.0f}    // Brown team
+    };
+
+    // Always leave room for the camera-followed entities
+    if (max_entities < NUM_AI_ENTITIES) max_entities = NUM_AI_ENTITIES;
+    if (initial_entities > max_entities) initial_entities = max_entities;
+
+    release_entities(world);
+    free_buffer(world);
+    if (!entity_store_init(world.entities, max_entities)) {
+        return false;
+    }
+
+    EntityStore& entities = world.entities;
+    world.tick = 0;
+    world.accumulator = 0.0f;
+    world.interpolation_alpha = 1.0f;
+
+    for (int i = 0; i < initial_entities; i++) {
+        if (i < NUM_AI_ENTITIES) {
+            entity_store_spawn(entities, start_positions[i][0], start_positions[i][1], i);
+        } else {
+            int index = entity_store_spawn(entities, 0.0f, 0.0f, i % 4);
+
+            // Scatter across the world using the entity's own spawn stream
+            float rolls[4];
+            rng_uniform4(world.seed, entities.id[index], 0, RNG_STREAM_SPAWN, rolls);
+            entities.x[index] = (rolls[0] * 2.0f - 1.0f) * world.world_bounds;
+            entities.y[index] = (rolls[1] * 2.0f - 1.0f) * world.world_bounds;
+            entities.prev_x[index] = entities.x[index];
+            entities.prev_y[index] = entities.y[index];
+        }
+    }
+
+    world_replaced(world);
+    return true;
+}
+
+void world_free(World& world) {
+    release_entities(world);
+    free_buffer(world);
+}
+
+int world_spawn(World& world, float x, float y, int team) {
+    // Teams index the flow fields and the renderer's colours
+    if (team < 0 || team >= FLOW_MAX_TEAMS) return -1;
+    world_lod_sync(world);
+    world.replay_keyframe_pending = true;
+    world.spatial_grid_dirty = true;
+
+    // Picks a direction on the next step
+    int index = entity_store_spawn(world.entities, x, y, team);
+    if (index >= 0) {
+        world.entities.decision_tick[index] = world.tick;
+        timing_wheel_schedule(world.decision_wheel, world.entities.id[index], world.tick);
+    }
+    return index;
+}
+
+bool world_despawn(World& world, int index) {
+    world_lod_sync(world); // dense indices are about to move
+    world.replay_keyframe_pending = true;
+    if (index >= 0 && index < world.entities.count) {
+        timing_wheel_cancel(world.decision_wheel, world.entities.id[index]);
+    }
+    world.spatial_grid_dirty = true;
+    return entity_store_despawn(world.entities, index);
+}
+
+bool world_attach(World& world, const WorldFileHeader* header, void* data) {
+    // The flow field's cell size is the world's own, not the snapshot's
+    if (!header || !world_file_cells_fit(header->world_bounds, world.flow_cell_size)) return false;
+    EntityStore store;
+    if (!entity_store_attach(store, header->capacity, header->count, header->free_id_count,
+                             (char*)data + header->block_offset)) {
+        return false;
+    }
+    // Teams index the per-team flow fields
+    for (int i = 0; i < store.count; i++) {
+        if (store.team[i] < 0 || store.team[i] >= FLOW_MAX_TEAMS) return false;
+    }
+
+    release_entities(world);
+    world.entities = store;
+    world.seed = header->seed;
+    world.tick = header->tick;
+    world.world_bounds = header->world_bounds;
+    world.ai_speed = header->ai_speed;
+    world.spatial_cell_size = header->spatial_cell_size;
+    world.fixed_step = header->fixed_step;
+    world.accumulator = header->fixed_step > 0.0f ? header->accumulator : 0.0f;
+    world.interpolation_alpha = world.fixed_step > 0.0f ? world.accumulator / world.fixed_step : 1.0f;
+    world_replaced(world);
+    return true;
+}
+
+void* world_alloc_buffer(World& world, int size) {
+    // The current world may be running on the previous buffer
+    release_entities(world);
+    world.spatial_grid_dirty = true;
+    free_buffer(world);
+
+    if (size > 0) {
+        world.world_buffer = ::operator new((size_t)size, std::align_val_t(ENTITY_STORE_ALIGNMENT), std::nothrow);
+    }
+    return world.world_buffer;
+}
+
+#ifndef __EMSCRIPTEN__
+bool world_save(World& world, const char* path) {
+    world_lod_sync(world);
+    if (!world.entities.block) return false;
+
+    WorldFileHeader header;
+    world_fill_header(world, header);
+    return world_file_write(path, header, world.entities.block);
+}
+
+bool world_load(World& world, const char* path) {
+    WorldFileMapping mapping;
+    if (!world_file_map(path, mapping)) return false;
+
+    if (!world_attach(world, world_file_validate(mapping.data, mapping.size), mapping.data)) {
+        world_file_unmap(mapping);
+        return false;
+    }
+    world.world_mapping = mapping;
+    return true;
+}
+#endif
+
+void world_start_replay(World& world, int keyframe_interval) {
+    replay_recorder_begin(world.replay, world.world_bounds, world.ai_speed, keyframe_interval);
+    world.replay_recording = true;
+    world.replay_keyframe_pending = true;
+}
+
+void world_set_flow_cost(World& world, float min_x, float min_y, float max_x, float max_y, int cost) {
+    FlowField& flow = world.flow;
+    if (flow.cost.empty()) return;
+    uint8_t c = (uint8_t)(cost < 1 ? 1 : (cost > FLOW_BLOCKED ? FLOW_BLOCKED : cost));
+    int n = flow.cells_per_side;
+    int first = flow_field_cell(flow, min_x, min_y);
+    int last = flow_field_cell(flow, max_x, max_y);
+    for (int cy = first / n; cy <= last / n; cy++) {
+        for (int cx = first % n; cx <= last % n; cx++) flow_field_set_cost(flow, cy * n + cx, c);
+    }
+}
+
+int world_lod_tier_count(const World& world, int tier) {
+    if (tier < 0 || tier >= LOD_TIERS) return 0;
+    if (!world.lod_active) return tier == 0 ? world.entities.count : 0;
+    int count = 0;
+    for (int i = 0; i < world.entities.count; i++) count += world.lod_tier[i] == tier;
+    return count;
+}
@@ -0,0 +1,154 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include "game.h"
+#include "entity_store.h"
+#include "spatial_grid.h"
+#include "timing_wheel.h"
+#include "world_file.h"
+#include "replay.h"
+#include "steering.h"
+#include "flow_field.h"
+#include "lod.h"
+#include <cstdint>
+#include <vector>
+
+// One simulated world: the entity store and everything a step reads or
+// writes. game.cpp drives a single world behind the extern "C" API; native
+// tools can create as many as they like and step them independently.
+//
+// Value-initialise a World (World world{}, std::vector<World>(n)) so the
+// plain members start at zero, then world_init it. Worlds own raw memory and
+// are not copyable in practice: pass them by reference and world_free them.
+
+#define WORLD_UPDATE_CHUNK 16384 // entities per job, a multiple of the decision batch
+
+struct World {
+    EntityStore entities;
+    float ai_speed = 150.0f;      // pixels per second
+    float world_bounds = 1000.0f; // world size
+    uint32_t seed = 42;           // fixed seed for reproducible behaviour
+    uint32_t tick = 0;            // steps since world_init
+
+    // Runs every job on the calling thread, in chunk order. Only one thread
+    // may be inside job_system_parallel_for, so worlds stepped side by side on
+    // the pool must be serial; the results are the same either way.
+    bool serial = false;
+
+    // Fixed-timestep mode: world_advance runs whole steps of fixed_step
+    // seconds and carries the remainder over. 0 means one variable step per frame.
+    float fixed_step = 0.0f;
+    int max_steps_per_frame = 5;
+    float accumulator = 0.0f;
+    float interpolation_alpha = 1.0f; // render position between the previous and current step
+    float delta_time = 0.0f;          // length of the step being run
+
+    SpatialGrid spatial_grid;
+    float spatial_cell_size = 50.0f;
+    bool spatial_grid_dirty = true; // entities spawned/despawned since the last rebuild
+
+    // Direction changes are scheduled on a timing wheel keyed on tick, so a
+    // step only touches the entities deciding in it. decision_tick holds each
+    // entity's due tick, and despawning takes the entity off the wheel.
+    TimingWheel decision_wheel;
+    std::vector<uint32_t> due_ids; // slot taken from the wheel this step
+    std::vector<int32_t> fired;    // dense indices deciding this step
+
+    // Memory a loaded world runs on instead of its own allocation
+#ifndef __EMSCRIPTEN__
+    WorldFileMapping world_mapping;
+#endif
+    void* world_buffer = nullptr; // from world_alloc_buffer
+
+    // Replay recording: a step's direction changes are the fired decisions, in
+    // wheel order, then each update chunk's turned, bounced and pushed
+    // entities in chunk order, so the stream does not depend on the worker count
+    ReplayRecorder replay;
+    bool replay_recording = false;
+    bool replay_keyframe_pending = false; // entity set changed since the last step
+    std::vector<std::vector<int32_t>> chunk_corrections;
+
+    // Agent-agent collisions, resolved after integration (collision.h)
+    bool collisions = false;
+    std::vector<float> push_x, push_y;
+    std::vector<float> cell_x, cell_y; // positions in grid order
+    std::vector<int> chunk_contacts;
+    int collision_contacts = 0; // overlapping pairs found by the last step
+
+    // Steering (steering.h). Velocities are steered into separate arrays,
+    // since every entity reads its neighbours' current ones, and copied over
+    // by the update chunks.
+    int ai_behaviour = AI_BEHAVIOUR_RANDOM_WALK;
+    SteeringParams steering = steering_default_params(150.0f);
+    SteeringCells steering_cells;
+    std::vector<float> steer_vx, steer_vy;
+    std::vector<uint8_t> turned; // velocity changed by steering or goal seeking this step
+
+    // Goal seeking along per-team flow fields (flow_field.h). Fields catch up
+    // with goal and cost changes at the start of a step, then every entity of
+    // a team with goals turns towards its cell's direction.
+    FlowField flow;
+    float flow_cell_size = 25.0f;
+    bool flow_seeking = false; // some team has goals
+
+    // Simulation level of detail (lod.h), around the entities with ids 0-3.
+    // lod_stepped_tick says how far each entity has been integrated; it lags
+    // tick for far entities between their steps. Replays step everyone, so
+    // tiers are suspended while one records.
+    bool lod_enabled = false;
+    bool lod_active = false;  // the current step runs tiers
+    bool lod_lagging = false; // some entity may be behind tick
+    float lod_step_time = 0.0f; // step length the lagging entities catch up with
+    LodParams lod = lod_default_params();
+    LodViews lod_views;
+    std::vector<uint8_t> lod_tier;
+    std::vector<uint32_t> lod_stepped_tick;
+    std::vector<float> lod_steps; // steps each entity takes this tick
+};
+
+// Sizes the store for max_entities and spawns initial_entities: the first
+// four at the fixed team start positions (ids 0-3), the rest scattered across
+// the world from the seed. Parameters set on the world beforehand apply.
+bool world_init(World& world, int max_entities, int initial_entities);
+// Drops the entities, any file mapping and buffer the world runs on
+void world_free(World& world);
+
+// One step of delta_time seconds
+void world_step(World& world, float delta_time);
+// Fixed-timestep frame (see advance_game); returns the interpolation alpha
+float world_advance(World& world, float frame_time);
+void world_set_fixed_timestep(World& world, float ticks_per_second, int max_steps_per_frame);
+
+// Picks a direction on the next step; -1 when the store is full or the team
+// is outside 0-3
+int world_spawn(World& world, float x, float y, int team);
+bool world_despawn(World& world, int index);
+
+// Makes sure the grid matches the current entity set before querying it
+void world_ensure_spatial_grid(World& world);
+// Brings every lagging entity up to the current tick (see lod.h)
+void world_lod_sync(World& world);
+// Furthest an entity can get from its previous position in one step, per axis
+float world_step_max_travel(const World& world);
+
+// World snapshots (world_file.h)
+void world_fill_header(const World& world, WorldFileHeader& header);
+// Runs on a snapshot's block in place; the memory must stay alive until the
+// next world_free or load. Fails, leaving the world as it was, unless the
+// block's id tables are consistent, every team is 0-3 and the world's flow
+// cell size fits the snapshot's bounds (world_file_cells_fit).
+bool world_attach(World& world, const WorldFileHeader* header, void* data);
+// Aligned memory owned by the world for a snapshot to be copied into. Drops
+// the current entities, which may be running on the previous buffer.
+void* world_alloc_buffer(World& world, int size);
+#ifndef __EMSCRIPTEN__
+bool world_save(World& world, const char* path);
+bool world_load(World& world, const char* path);
+#endif
+
+void world_start_replay(World& world, int keyframe_interval);
+void world_set_flow_cost(World& world, float min_x, float min_y, float max_x, float max_y, int cost);
+// Entities in a tier after the last step
+int world_lod_tier_count(const World& world, int tier);
+
+#endif
@@ -0,0 +1,139 @@
+#include "world_file.h"
+#include "entity_store.h"
+#include <cmath>
+#include <cstring>
+
+#ifndef __EMSCRIPTEN__
+#include <cstdio>
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#endif
+
+static_assert(sizeof(WorldFileHeader) == 64, "world file header is one cache line");
+static_assert(WORLD_FILE_BLOCK_ALIGNMENT == ENTITY_STORE_ALIGNMENT, "blocks are attached in place");
+
+size_t world_file_size(int capacity) {
+    return sizeof(WorldFileHeader) + entity_store_block_size(capacity);
+}
+
+void world_file_init_header(WorldFileHeader& header) {
+    header.magic = WORLD_FILE_MAGIC;
+    header.version = WORLD_FILE_VERSION;
+    header.header_size = (uint32_t)sizeof(WorldFileHeader);
+    header.block_offset = (uint32_t)sizeof(WorldFileHeader); // already a multiple of the alignment
+    header.block_size = entity_store_block_size(header.capacity);
+}
+
+const WorldFileHeader* world_file_validate(const void* data, size_t size) {
+    if (!data || size < sizeof(WorldFileHeader)) return nullptr;
+    const WorldFileHeader* header = (const WorldFileHeader*)data;
+
+    if (header->magic != WORLD_FILE_MAGIC || header->version != WORLD_FILE_VERSION ||
+        header->header_size != sizeof(WorldFileHeader)) {
+        return nullptr;
+    }
+    if (header->capacity <= 0 || header->count < 0 || header->count > header->capacity ||
+        header->free_id_count != header->capacity - header->count) {
+        return nullptr;
+    }
+    if (header->block_offset % WORLD_FILE_BLOCK_ALIGNMENT != 0 ||
+        header->block_size != entity_store_block_size(header->capacity) ||
+        header->block_offset > size || header->block_size > size - header->block_offset) {
+        return nullptr;
+    }
+    if (!world_file_cells_fit(header->world_bounds, header->spatial_cell_size) || !std::isfinite(header->ai_speed) ||
+        !std::isfinite(header->fixed_step) || !(header->fixed_step >= 0.0f) || !std::isfinite(header->accumulator)) {
+        return nullptr;
+    }
+    return header;
+}
+
+bool world_file_cells_fit(float world_bounds, float cell_size) {
+    if (!std::isfinite(world_bounds) || !std::isfinite(cell_size) || !(world_bounds > 0.0f) || !(cell_size > 0.0f)) {
+        return false;
+    }
+    return 2.0 * world_bounds / cell_size <= WORLD_FILE_MAX_CELLS_PER_SIDE;
+}
+
+void world_file_serialize(const WorldFileHeader& header, const void* block, void* out) {
+    memcpy(out, &header, sizeof(header));
+    memcpy((char*)out + header.block_offset, block, (size_t)header.block_size);
+}
+
+#ifndef __EMSCRIPTEN__
+bool world_file_write(const char* path, const WorldFileHeader& header, const void* block) {
+    FILE* file = fopen(path, "wb");
+    if (!file) return false;
+
+    bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+              fwrite(block, 1, (size_t)header.block_size, file) == (size_t)header.block_size;
+    return fclose(file) == 0 && ok;
+}
+
+#ifdef _WIN32
+bool world_file_map(const char* path, WorldFileMapping& mapping) {
+    memset(&mapping, 0, sizeof(mapping));
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) return false;
+
+    LARGE_INTEGER size;
+    HANDLE handle = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0) {
+        handle = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+    }
+    CloseHandle(file); // the mapping keeps the file open
+    if (!handle) return false;
+
+    mapping.data = MapViewOfFile(handle, FILE_MAP_COPY, 0, 0, 0);
+    if (!mapping.data) {
+        CloseHandle(handle);
+        return false;
+    }
+    mapping.size = (size_t)size.QuadPart;
+    mapping.handle = handle;
+    return true;
+}
+
+void world_file_unmap(WorldFileMapping& mapping) {
+    if (mapping.data) {
+        UnmapViewOfFile(mapping.data);
+        CloseHandle((HANDLE)mapping.handle);
+    }
+    memset(&mapping, 0, sizeof(mapping));
+}
+#else
+bool world_file_map(const char* path, WorldFileMapping& mapping) {
+    memset(&mapping, 0, sizeof(mapping));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size <= 0) {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // the mapping keeps the file open
+    if (data == MAP_FAILED) return false;
+
+    mapping.data = data;
+    mapping.size = (size_t)info.st_size;
+    return true;
+}
+
+void world_file_unmap(WorldFileMapping& mapping) {
+    if (mapping.data) {
+        munmap(mapping.data, mapping.size);
+    }
+    memset(&mapping, 0, sizeof(mapping));
+}
+#endif
+#endif
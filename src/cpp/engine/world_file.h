@@ -0,0 +1,70 @@
+#ifndef WORLD_FILE_H
+#define WORLD_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Binary world snapshot: a 64-byte header followed, at a 64-byte aligned
+// offset, by the entity store's block exactly as it sits in memory (see
+// entity_store_block_size). Loading is validating the header and pointing the
+// store's arrays into the file, so nothing is parsed or copied. The random
+// streams need no state beyond the seed, the tick and the per-entity decision
+// counts, which live in the block. Little-endian only: a file written on a
+// big-endian machine fails the magic check.
+
+#define WORLD_FILE_MAGIC 0x574D4953u // "SIMW"
+#define WORLD_FILE_VERSION 2 // 2: decision ticks replace float move timers
+#define WORLD_FILE_BLOCK_ALIGNMENT 64
+// Most grid or flow field cells per side a snapshot's world may need, so
+// cells_per_side squared stays far inside an int and the allocation sane
+#define WORLD_FILE_MAX_CELLS_PER_SIDE 4096
+
+struct WorldFileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t header_size;
+    int32_t capacity;       // entities the block is laid out for
+    int32_t count;
+    int32_t free_id_count;
+    uint32_t seed;
+    uint32_t tick;
+    float world_bounds;
+    float ai_speed;
+    float spatial_cell_size;
+    float fixed_step;       // 0 = variable steps
+    float accumulator;      // unsimulated time carried into the next frame
+    uint32_t block_offset;  // from the start of the file
+    uint64_t block_size;
+};
+
+// Total size of a snapshot of a store with this capacity
+size_t world_file_size(int capacity);
+// Fills in magic, version, header size and the block placement
+// for header->capacity; the caller sets the world fields.
+void world_file_init_header(WorldFileHeader& header);
+// Checks a snapshot held in memory and returns its header, or nullptr when
+// it is truncated, from another version or inconsistent, or its world
+// fields are not finite or need more than WORLD_FILE_MAX_CELLS_PER_SIDE
+const WorldFileHeader* world_file_validate(const void* data, size_t size);
+// Whether a grid of cell_size cells over [-world_bounds, world_bounds] is
+// within WORLD_FILE_MAX_CELLS_PER_SIDE; false for non-finite or non-positive sizes
+bool world_file_cells_fit(float world_bounds, float cell_size);
+// Header plus block into out, which must hold world_file_size(capacity) bytes
+void world_file_serialize(const WorldFileHeader& header, const void* block, void* out);
+
+#ifndef __EMSCRIPTEN__
+bool world_file_write(const char* path, const WorldFileHeader& header, const void* block);
+
+// A world file mapped copy-on-write: the simulation can run directly on the
+// mapping, and pages it writes become private without touching the file.
+struct WorldFileMapping {
+    void* data;
+    size_t size;
+    void* handle; // platform mapping handle, unused on POSIX
+};
+
+bool world_file_map(const char* path, WorldFileMapping& mapping);
+void world_file_unmap(WorldFileMapping& mapping);
+#endif
+
+#endif
@@ -1,5 +1,6 @@
 #include "engine/renderer.h"
 #include "engine/game.h"
+#include "engine/profiler.h"
 #include <emscripten.h>
 #include <emscripten/html5.h>
 #include <emscripten/html5_webgl.h>
@@ -7,42 +8,87 @@
 static double g_last_time = 0.0;
 
 static EMSCRIPTEN_WEBGL_CONTEXT_HANDLE g_contexts[4];
+static bool g_shared_context = false; // one context and canvas for all viewports
 
 static void game_loop() {
+    PROFILE_BEGIN_FRAME();
+
     double current_time = emscripten_get_now() / 1000.0;
     float delta_time = (float)(current_time - g_last_time);
     g_last_time = current_time;
 
     if (delta_time > 0.1f) delta_time = 0.1f; // Cap delta time
 
-    update_game(delta_time);
-
-    // Collect all AI positions
-    float ai_positions[4][2];
-    int ai_teams[4];
+    // Whole fixed steps only; positions are drawn interpolated by the remainder.
+    // With a worker thread the steps run while the viewports below render the
+    // previously published state.
+    begin_game_step(delta_time);
 
+    // Render each followed AI entity's perspective (ids 0-3) to the appropriate canvas
     for (int i = 0; i < 4; i++) {
-        ai_positions[i][0] = get_ai_x(i); // x
-        ai_positions[i][1] = get_ai_y(i); // y
-        ai_teams[i] = get_ai_team(i);
-    }
-
-    // Render each AI entity's perspective to the appropriate canvas
-    const char* canvas_ids[4] = {"#canvas-red", "#canvas-blue", "#canvas-purple", "#canvas-brown"};
+        // Switch to the appropriate WebGL context (single-context mode never switches)
+        if (!g_shared_context) {
+            PROFILE_SCOPE(PROFILE_CONTEXT_SWITCH);
+            emscripten_webgl_make_context_current(g_contexts[i]);
+        }
 
-    for (int i = 0; i < 4; i++) {
-        // Switch to the appropriate WebGL context
-        emscripten_webgl_make_context_current(g_contexts[i]);
+        float center_x = get_camera_x(i);
+        float center_y = get_camera_y(i);
 
-        render_frame_for_viewport(ai_positions[i][0], ai_positions[i][1], 50.0f, i, ai_positions, ai_teams);
+        // Only what this camera sees is submitted as squares
+        const ViewCull* view = cull_ai_view(i, center_x, center_y,
+                                            get_viewport_width() / 2.0f, get_viewport_height() / 2.0f);
+        render_frame_for_viewport(center_x, center_y, 50.0f, i, view);
     }
+
+    PROFILE_END_FRAME();
 }
 
 extern "C" {
     EMSCRIPTEN_KEEPALIVE
     void init() {
         g_last_time = emscripten_get_now() / 1000.0;
-        init_game();
+        init_game(NUM_AI_ENTITIES, NUM_AI_ENTITIES);
+
+        // Simulation tick rate from the page (0 = one variable step per frame)
+        float tick_rate = (float)EM_ASM_DOUBLE({
+            return Module.tickRate !== undefined ? Module.tickRate : 60;
+        });
+        set_fixed_timestep(tick_rate, 5);
+
+        // Entities push each other apart instead of overlapping when the page asks
+        if (EM_ASM_INT({ return Module.collisions ? 1 : 0; })) {
+            set_collisions(1);
+        }
+
+        // Team flocking when the page asks for it
+        if (EM_ASM_INT({ return Module.flock ? 1 : 0; })) {
+            set_ai_behaviour(AI_BEHAVIOUR_FLOCK);
+        }
+
+        // Entities far from every camera are stepped less often
+        if (EM_ASM_INT({ return Module.lod ? 1 : 0; })) {
+            set_simulation_lod(1);
+        }
+
+        // Teams head for the opposite corner, around a wall with a gap in it
+        if (EM_ASM_INT({ return Module.goals ? 1 : 0; })) {
+            set_flow_cost(-400.0f, -20.0f, 400.0f, 20.0f, 255);
+            set_flow_cost(-40.0f, -20.0f, 40.0f, 20.0f, 1);
+            add_team_goal(TEAM_RED, 900.0f, 900.0f);
+            add_team_goal(TEAM_BLUE, -900.0f, 900.0f);
+            add_team_goal(TEAM_PURPLE, 900.0f, -900.0f);
+            add_team_goal(TEAM_BROWN, -900.0f, -900.0f);
+        }
+
+        // One simulation worker per core (ignored unless built with pthreads)
+        int num_cores = EM_ASM_INT({
+            return navigator.hardwareConcurrency || 1;
+        });
+        set_worker_count(num_cores);
+
+        // Overlap simulation with rendering (stays synchronous without pthreads)
+        set_async_simulation(1);
         
         // Ensure WebGL context is created before initializing renderer
         EmscriptenWebGLContextAttributes attrs;
@@ -54,6 +100,34 @@ extern "C" {
         attrs.stencil = false;
         attrs.antialias = false;
         
+        // The page opts into rendering all viewports through one canvas and context
+        g_shared_context = EM_ASM_INT({
+            return Module.sharedContext ? 1 : 0;
+        }) != 0;
+
+        if (g_shared_context) {
+            // The shared canvas holds the four viewports as quadrants
+            int viewport_width = EM_ASM_INT({
+                const canvas = document.querySelector("#canvas-shared");
+                return canvas ? Math.floor(canvas.width / 2) : 400;
+            });
+            int viewport_height = EM_ASM_INT({
+                const canvas = document.querySelector("#canvas-shared");
+                return canvas ? Math.floor(canvas.height / 2) : 400;
+            });
+
+            EMSCRIPTEN_WEBGL_CONTEXT_HANDLE context = emscripten_webgl_create_context("#canvas-shared", &attrs);
+            if (context > 0) {
+                emscripten_webgl_make_context_current(context);
+                init_renderer(viewport_width, viewport_height, 0);
+                set_shared_context(1);
+            }
+            for (int i = 0; i < 4; i++) {
+                g_contexts[i] = context;
+            }
+            return;
+        }
+
         // Create WebGL contexts for all 4 canvases
         const char* canvas_ids[4] = {"#canvas-red", "#canvas-blue", "#canvas-purple", "#canvas-brown"};
 
@@ -1,5 +1,31 @@
 let wasmModule = null;
 
+// ?contexts=1 renders all four viewports into one canvas through a single
+// WebGL context instead of one canvas and context per viewport. It needs a
+// build/game.wasm rebuilt from the current sources: an older build ignores
+// the option and would draw into the hidden per-viewport canvases.
+const sharedContext = new URLSearchParams(window.location.search).get('contexts') === '1';
+
+// Simulation ticks per second; ?tick=30 runs big worlds at a lower rate with
+// interpolated rendering, ?tick=0 goes back to one variable step per frame.
+const tickParam = new URLSearchParams(window.location.search).get('tick');
+const tickRate = tickParam !== null && !isNaN(Number(tickParam)) ? Number(tickParam) : 60;
+
+// ?behaviour=flock steers entities by their neighbours on top of the random walk
+const flock = new URLSearchParams(window.location.search).get('behaviour') === 'flock';
+
+// ?goals=1 sends each team across the world along its flow field
+const goals = new URLSearchParams(window.location.search).get('goals') === '1';
+
+// ?collisions=1 pushes overlapping entities apart
+const collisions = new URLSearchParams(window.location.search).get('collisions') === '1';
+
+// ?lod=1 steps entities far from every camera less often
+const lod = new URLSearchParams(window.location.search).get('lod') === '1';
+
+// World snapshot to start from instead of the default world, e.g. ?world=big.world
+const worldUrl = new URLSearchParams(window.location.search).get('world');
+
 function resizeCanvases() {
     const canvases = [
         document.getElementById('canvas-red'),
@@ -24,6 +50,11 @@ function resizeCanvases() {
         canvas.height = canvasHeight;
     }
 
+    // The shared canvas holds all four viewports as quadrants
+    const sharedCanvas = document.getElementById('canvas-shared');
+    sharedCanvas.width = canvasWidth * 2;
+    sharedCanvas.height = canvasHeight * 2;
+
     // Update renderer if initialized
     if (wasmModule && wasmModule._resize_renderer) {
         wasmModule._resize_renderer(canvasWidth, canvasHeight);
@@ -32,6 +63,92 @@ function resizeCanvases() {
     return { width: canvasWidth, height: canvasHeight };
 }
 
+// Typed-array views over the simulation's entity arrays in WASM memory, read
+// from the SimSnapshot struct (x, y, team, id pointers, count, stride). No data
+// is copied. Views go stale when entities spawn or despawn and are detached if
+// memory grows, so fetch fresh ones each frame rather than keeping them.
+function getEntityViews() {
+    if (!wasmModule || !wasmModule._get_sim_snapshot) return null;
+
+    const words = wasmModule.HEAPU32;
+    const snapshot = wasmModule._get_sim_snapshot() >> 2;
+    const count = words[snapshot + 4];
+    const buffer = wasmModule.HEAPF32.buffer;
+
+    return {
+        count: count,
+        x: new Float32Array(buffer, words[snapshot], count),
+        y: new Float32Array(buffer, words[snapshot + 1], count),
+        team: new Int32Array(buffer, words[snapshot + 2], count),
+        id: new Uint32Array(buffer, words[snapshot + 3], count)
+    };
+}
+window.getEntityViews = getEntityViews;
+
+// Profiler ring (builds made with "build.bat profile"). Each frame is
+// PROFILER_FRAME_WORDS = 10 32-bit words: frame index, frame ms, sim, cull,
+// render, upload, draw and context switch ms, GL calls, draw calls. Returns
+// the frames oldest first, or an empty list when the profiler is compiled out.
+function getProfilerFrames() {
+    if (!wasmModule || !wasmModule._get_profiler_frames) return [];
+
+    const frameWords = 10;
+    const capacity = wasmModule._get_profiler_frame_capacity();
+    const total = wasmModule._get_profiler_frame_count();
+    const base = wasmModule._get_profiler_frames() >> 2;
+    const floats = wasmModule.HEAPF32;
+    const words = wasmModule.HEAPU32;
+
+    const frames = [];
+    for (let n = Math.max(0, total - capacity); n < total; n++) {
+        const at = base + (n % capacity) * frameWords;
+        frames.push({
+            frame: words[at],
+            frameMs: floats[at + 1],
+            simMs: floats[at + 2],
+            cullMs: floats[at + 3],
+            renderMs: floats[at + 4],
+            uploadMs: floats[at + 5],
+            drawMs: floats[at + 6],
+            contextSwitchMs: floats[at + 7],
+            glCalls: words[at + 8],
+            drawCalls: words[at + 9]
+        });
+    }
+    return frames;
+}
+window.getProfilerFrames = getProfilerFrames;
+
+// Replace the running world with a binary snapshot (see world_file.h). The
+// bytes are copied once into an aligned buffer owned by the game, which then
+// simulates on them in place.
+async function loadWorld(url) {
+    const response = await fetch(url);
+    if (!response.ok) throw new Error(`Could not fetch ${url}: ${response.status}`);
+    const bytes = new Uint8Array(await response.arrayBuffer());
+
+    const pointer = wasmModule._alloc_world_buffer(bytes.length);
+    if (!pointer) throw new Error('Out of memory for world snapshot');
+    wasmModule.HEAPU8.set(bytes, pointer);
+    if (!wasmModule._load_world_from_memory(pointer, bytes.length)) {
+        throw new Error(`${url} is not a valid world snapshot`);
+    }
+}
+window.loadWorld = loadWorld;
+
+// Snapshot of the running world as a Blob, e.g. to save for ?world=
+function saveWorld() {
+    const size = wasmModule._get_world_snapshot_size();
+    const pointer = wasmModule._malloc(size);
+    try {
+        if (!wasmModule._write_world_snapshot(pointer, size)) return null;
+        return new Blob([wasmModule.HEAPU8.slice(pointer, pointer + size)], { type: 'application/octet-stream' });
+    } finally {
+        wasmModule._free(pointer);
+    }
+}
+window.saveWorld = saveWorld;
+
 async function init() {
     // Resize canvases to proper aspect ratio before initialization
     resizeCanvases();
@@ -43,8 +160,16 @@ async function init() {
         document.getElementById('canvas-brown')
     ];
 
+    // Show either the shared canvas or the per-viewport canvases
+    const sharedCanvas = document.getElementById('canvas-shared');
+    sharedCanvas.style.display = sharedContext ? 'block' : 'none';
+    for (const canvas of canvases) {
+        canvas.style.display = sharedContext ? 'none' : 'block';
+    }
+    const firstCanvas = sharedContext ? sharedCanvas : canvases[0];
+
     // Check WebGL2 support on first canvas
-    if (!canvases[0].getContext('webgl2') && !canvases[0].getContext('experimental-webgl2')) {
+    if (!firstCanvas.getContext('webgl2') && !firstCanvas.getContext('experimental-webgl2')) {
         alert('WebGL 2.0 not supported!');
         return;
     }
@@ -55,6 +180,12 @@ async function init() {
     // Load WASM module - let Emscripten create the WebGL context
     try {
         wasmModule = await Module({
+            sharedContext: sharedContext,
+            tickRate: tickRate,
+            flock: flock,
+            collisions: collisions,
+            goals: goals,
+            lod: lod,
             onRuntimeInitialized: function() {
                 // 'this' refers to the Module instance
                 // Set wasmModule so input handlers can access it
@@ -63,6 +194,9 @@ async function init() {
                 // Initialize game - WebGL context should be ready now
                 try {
                     wasmModule._init();
+                    if (worldUrl) {
+                        loadWorld(worldUrl).catch(error => console.error('Error loading world:', error));
+                    }
                     
                     // Start game loop - suppress Emscripten's harmless "unwind" exception
                     try {